@@ -17,13 +17,15 @@
 
 #pragma once
 
+#include <QHash>
 #include <QImage>
 #include <QObject>
+#include <QSet>
 #include <QSharedPointer>
 #include <QUrl>
 
+#include "Identifier.h"
 #include "MatrixClient.h"
-#include "TimelineItem.h"
 
 class AvatarProvider : public QObject
 {
@@ -31,17 +33,20 @@ class AvatarProvider : public QObject
 
 public:
         static void init(QSharedPointer<MatrixClient> client);
-        static void resolve(const QString &userId, TimelineItem *item);
-        static void setAvatarUrl(const QString &userId, const QUrl &url);
+
+        // The cached avatar of the user. A missing one is fetched in the
+        // background and a null image is returned until it arrives.
+        static QImage avatar(const matrix::Identifier &userId);
+        static void setAvatarUrl(const matrix::Identifier &userId, const QUrl &url);
 
         static void clear();
 
 private:
-        static void updateAvatar(const QString &uid, const QImage &img);
+        static void updateAvatar(const QString &userId, const QImage &img);
 
         static QSharedPointer<MatrixClient> client_;
-        static QMap<QString, QList<TimelineItem *>> toBeResolved_;
+        static QSet<matrix::Identifier> requested_;
 
-        static QMap<QString, QImage> userAvatars_;
-        static QMap<QString, QUrl> avatarUrls_;
+        static QHash<matrix::Identifier, QImage> userAvatars_;
+        static QHash<matrix::Identifier, QUrl> avatarUrls_;
 };
@@ -18,20 +18,58 @@
 #pragma once
 
 #include <QDir>
+#include <QList>
+#include <QVector>
 #include <lmdb++.h>
 
+#include "OutboundMessage.h"
+#include "RoomMessages.h"
+#include "RoomRegistry.h"
 #include "RoomState.h"
+#include "Sync.h"
 
 class Cache
 {
 public:
         Cache(const QString &userId);
 
-        void setState(const QString &nextBatchToken, const QMap<QString, RoomState> &states);
+        // Store the state of every room in the registry.
+        void setState(const QString &nextBatchToken, const RoomRegistry &registry);
+        // Store only the state of the given rooms.
+        void setState(const QString &nextBatchToken,
+                      const RoomRegistry &registry,
+                      const QVector<RoomHandle> &rooms);
+        // Keep the newest events of the rooms, in the batches they were
+        // received in, up to TimelineTailSize events per room. A limited
+        // batch marks the gap before it. The timelines are rebuilt from the
+        // tail, older events are paginated from the server.
+        void saveTimelines(const QMap<QString, Timeline> &timelines);
+        // Keep a page of history that continues the tail of the room, while
+        // the tail has room for it.
+        void saveHistory(const QString &roomid, const RoomMessages &msgs);
+        // The batches of the room, oldest first. Empty if nothing is stored.
+        QList<Timeline> timeline(const QString &roomid);
+        // The newest batch of every room.
+        QMap<QString, Timeline> timelines();
+
+        // Delete the state and the members of a room we left.
+        void removeRoom(const QString &roomid);
         bool isInitialized() const;
 
         QString nextBatchToken() const;
         QMap<QString, RoomState> states();
+        QMap<QString, UnreadNotifications> unreadNotifications();
+
+        // The read markers that haven't been acknowledged by the server.
+        void setPendingReadMarker(const QString &roomid, const QString &event_id);
+        void removePendingReadMarker(const QString &roomid);
+        QMap<QString, QString> pendingReadMarkers();
+
+        // The messages that aren't accepted by the server yet.
+        void saveOutboundMessage(const OutboundMessage &msg);
+        void removeOutboundMessage(int txn_id);
+        // Ordered by their transaction ID.
+        QList<OutboundMessage> outboundMessages();
 
         inline void deleteData();
         inline void unmount();
@@ -39,11 +77,26 @@ public:
 
 private:
         void setNextBatchToken(lmdb::txn &txn, const QString &token);
-        void insertRoomState(lmdb::txn &txn, const QString &roomid, const RoomState &state);
+        // Only the members that changed since the state was last stored are
+        // written. The state is marked as stored.
+        void insertRoomState(lmdb::txn &txn, const QString &roomid, RoomState &state);
+
+        QJsonArray timelineBatches(lmdb::txn &txn, const QByteArray &roomid);
+        void setTimelineBatches(lmdb::txn &txn,
+                                const QByteArray &roomid,
+                                const QJsonArray &batches);
+
+        // The number of events that are kept per room. Whole batches are
+        // dropped, so that the oldest one keeps its pagination token.
+        static const int TimelineTailSize;
 
         lmdb::env env_;
         lmdb::dbi stateDb_;
         lmdb::dbi roomDb_;
+        lmdb::dbi unreadDb_;
+        lmdb::dbi readMarkersDb_;
+        lmdb::dbi outboxDb_;
+        lmdb::dbi timelineDb_;
 
         bool isMounted_;
 
@@ -23,9 +23,12 @@
 
 #include "Cache.h"
 #include "MatrixClient.h"
+#include "Outbox.h"
 #include "QuickSwitcher.h"
+#include "ReadMarkerQueue.h"
 #include "RoomList.h"
 #include "RoomSettings.h"
+#include "RoomRegistry.h"
 #include "RoomState.h"
 #include "Splitter.h"
 #include "TextInputWidget.h"
@@ -66,10 +69,13 @@ protected:
         void keyPressEvent(QKeyEvent *event) override;
 
 private:
-        void updateDisplayNames(const RoomState &state);
         void loadStateFromCache();
         void showQuickSwitcher();
 
+        // Rooms joined or left after the initial sync.
+        RoomHandle addRoom(const QString &room_id, const JoinedRoom &data);
+        void removeRoom(RoomHandle room);
+
         QHBoxLayout *topLayout_;
         Splitter *splitter;
 
@@ -94,13 +100,12 @@ private:
         QTimer *sync_timer_;
         int sync_interval_;
 
-        QString current_room_;
-        QMap<QString, QPixmap> room_avatars_;
+        RoomHandle current_room_ = RoomRegistry::InvalidRoom;
 
         UserInfoWidget *user_info_widget_;
 
-        QMap<QString, RoomState> state_manager_;
-        QMap<QString, QSharedPointer<RoomSettings>> settingsManager_;
+        // The state, settings and avatar of every joined room.
+        QSharedPointer<RoomRegistry> registry_;
 
         QuickSwitcher *quickSwitcher_     = nullptr;
         OverlayModal *quickSwitcherModal_ = nullptr;
@@ -110,4 +115,9 @@ private:
 
         // LMDB wrapper.
         QSharedPointer<Cache> cache_;
+
+        ReadMarkerQueue *read_markers_;
+
+        // The messages of the user that aren't accepted by the server yet.
+        QSharedPointer<Outbox> outbox_;
 };
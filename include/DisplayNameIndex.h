@@ -0,0 +1,63 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+#include "Identifier.h"
+#include "MemberEventContent.h"
+
+namespace events = matrix::events;
+
+// The display names of the members of a single room.
+//
+// It is kept up to date from the membership events as they arrive and
+// resolves a user to the name that should be shown in the timeline. When two
+// or more members use the same display name, the user ID is appended to
+// tell them apart, as the specification suggests.
+class DisplayNameIndex
+{
+public:
+        // Apply a membership change. Members that left or got banned are removed.
+        void update(const matrix::Identifier &user_id, const events::MemberEventContent &member);
+        void remove(const matrix::Identifier &user_id);
+        void clear();
+
+        // The name to show for the user. Users without a display name are
+        // shown by their ID.
+        QString displayName(const matrix::Identifier &user_id) const;
+        QString displayName(const QString &user_id) const;
+
+        inline bool isEmpty() const;
+
+private:
+        void insert(const matrix::Identifier &user_id, const QString &name);
+
+        // The raw display name of each member.
+        QHash<matrix::Identifier, QString> names_;
+
+        // How many members use each display name.
+        QHash<QString, int> occurrences_;
+};
+
+inline bool
+DisplayNameIndex::isEmpty() const
+{
+        return names_.isEmpty();
+}
@@ -0,0 +1,69 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVector>
+
+// The IDs of the latest events of a timeline, used to drop the events that
+// are received twice (e.g from a sync and from a page of history).
+//
+// Only a 64 bit hash of each ID is kept, in two open addressing tables of a
+// fixed size. The insertions go to the newer table; once it is full the older
+// one is emptied and they swap. Between half and all of the last `capacity`
+// IDs are remembered and the memory never grows.
+class EventIdSet
+{
+public:
+        explicit EventIdSet(int capacity = DefaultCapacity);
+
+        bool contains(const QString &event_id) const;
+
+        // Return false if the ID was already in the set.
+        bool insert(const QString &event_id);
+        void clear();
+
+        // The number of IDs that are remembered.
+        int size() const;
+        inline int capacity() const;
+
+        static const int DefaultCapacity;
+
+private:
+        struct Table
+        {
+                QVector<quint64> slots;
+                int size = 0;
+        };
+
+        static quint64 hash(const QString &event_id);
+        static bool contains(const Table &table, quint64 key);
+
+        int capacity_;
+        // The mask of the slot index.
+        int mask_;
+
+        Table newer_;
+        Table older_;
+};
+
+inline int
+EventIdSet::capacity() const
+{
+        return capacity_;
+}
@@ -0,0 +1,95 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+
+namespace matrix
+{
+/*
+ * A Matrix identifier (user ID, room ID, event type) interned in a process wide table.
+ *
+ * Every distinct string is stored once and the identifier itself is just an integer
+ * handle, so copies, comparisons and hashing never touch the string data. The empty
+ * string is always handle 0. The table is append only and safe to use from any thread.
+ */
+class Identifier
+{
+public:
+        Identifier() = default;
+        explicit Identifier(const QString &id);
+
+        // Look up an identifier without interning it. An empty identifier is
+        // returned if the string has never been seen before.
+        static Identifier find(const QString &id);
+
+        // Number of distinct strings currently interned.
+        static int count();
+
+        QString toString() const;
+
+        inline quint32 handle() const;
+        inline bool isEmpty() const;
+
+        inline bool operator==(const Identifier &other) const;
+        inline bool operator!=(const Identifier &other) const;
+
+        // Orders by handle (i.e insertion order), not lexicographically.
+        inline bool operator<(const Identifier &other) const;
+
+private:
+        quint32 handle_ = 0;
+};
+
+inline quint32
+Identifier::handle() const
+{
+        return handle_;
+}
+
+inline bool
+Identifier::isEmpty() const
+{
+        return handle_ == 0;
+}
+
+inline bool
+Identifier::operator==(const Identifier &other) const
+{
+        return handle_ == other.handle_;
+}
+
+inline bool
+Identifier::operator!=(const Identifier &other) const
+{
+        return handle_ != other.handle_;
+}
+
+inline bool
+Identifier::operator<(const Identifier &other) const
+{
+        return handle_ < other.handle_;
+}
+
+inline uint
+qHash(const Identifier &id, uint seed = 0)
+{
+        return ::qHash(id.handle(), seed);
+}
+} // namespace matrix
@@ -37,10 +37,10 @@ public:
         // Client API.
         void initialSync() noexcept;
         void sync() noexcept;
-        void sendRoomMessage(matrix::events::MessageEventType ty,
-                             const QString &roomid,
-                             const QString &msg,
-                             const QString &url = "") noexcept;
+        // Retrying with the same transaction ID doesn't send the message twice.
+        void sendRoomMessage(const QString &roomid,
+                             int txn_id,
+                             const QJsonObject &content) noexcept;
         void login(const QString &username, const QString &password) noexcept;
         void registerUser(const QString &username,
                           const QString &password,
@@ -52,6 +52,8 @@ public:
         void downloadImage(const QString &event_id, const QUrl &url);
         void messages(const QString &room_id, const QString &from_token, int limit = 20) noexcept;
         void uploadImage(const QString &roomid, const QString &filename);
+        // Move both the read receipt and the fully read marker to the event.
+        void readMarkers(const QString &room_id, const QString &event_id) noexcept;
 
         inline QUrl getHomeServer();
         inline int transactionId();
@@ -92,8 +94,14 @@ signals:
         void syncCompleted(const SyncResponse &response);
         void syncFailed(const QString &msg);
         void messageSent(const QString &event_id, const QString &roomid, const int txn_id);
+        // The status is 0 if the homeserver couldn't be reached.
+        void messageSendFailed(const QString &roomid, const int txn_id, int status);
         void emoteSent(const QString &event_id, const QString &roomid, const int txn_id);
         void messagesRetrieved(const QString &room_id, const RoomMessages &msgs);
+        // The page of history from the token couldn't be retrieved.
+        void messagesFailed(const QString &room_id, const QString &from_token);
+        void readMarkersSent(const QString &room_id, const QString &event_id);
+        void readMarkersFailed(const QString &room_id, const QString &event_id);
 
 private slots:
         void onResponse(QNetworkReply *reply);
@@ -109,6 +117,7 @@ private:
                 Login,
                 Logout,
                 Messages,
+                ReadMarkers,
                 Register,
                 RoomAvatar,
                 SendRoomMessage,
@@ -126,6 +135,7 @@ private:
         void onLoginResponse(QNetworkReply *reply);
         void onLogoutResponse(QNetworkReply *reply);
         void onMessagesResponse(QNetworkReply *reply);
+        void onReadMarkersResponse(QNetworkReply *reply);
         void onRegisterResponse(QNetworkReply *reply);
         void onRoomAvatarResponse(QNetworkReply *reply);
         void onSendRoomMessage(QNetworkReply *reply);
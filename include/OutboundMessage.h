@@ -0,0 +1,93 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+#include "Deserializable.h"
+#include "MessageEventContent.h"
+
+// A message that waits in the outbox until the server accepts it. The
+// transaction ID is assigned once, so every retry of the message is
+// deduplicated by the server.
+class OutboundMessage
+  : public Deserializable
+  , public Serializable
+{
+public:
+        OutboundMessage() = default;
+        OutboundMessage(const QString &room_id,
+                        int txn_id,
+                        matrix::events::MessageEventType ty,
+                        const QString &body,
+                        const QString &url = "");
+
+        inline QString roomId() const;
+        inline int txnId() const;
+        inline matrix::events::MessageEventType type() const;
+        inline QString body() const;
+        inline QString url() const;
+
+        // The content of the m.room.message event.
+        inline QJsonObject content() const;
+
+        QJsonObject serialize() const override;
+        void deserialize(const QJsonObject &data) override;
+
+private:
+        QString room_id_;
+        int txn_id_ = 0;
+        QJsonObject content_;
+};
+
+inline QString
+OutboundMessage::roomId() const
+{
+        return room_id_;
+}
+
+inline int
+OutboundMessage::txnId() const
+{
+        return txn_id_;
+}
+
+inline matrix::events::MessageEventType
+OutboundMessage::type() const
+{
+        return matrix::events::extractMessageEventType(QJsonObject{ { "content", content_ } });
+}
+
+inline QString
+OutboundMessage::body() const
+{
+        return content_.value("body").toString();
+}
+
+inline QString
+OutboundMessage::url() const
+{
+        return content_.value("url").toString();
+}
+
+inline QJsonObject
+OutboundMessage::content() const
+{
+        return content_;
+}
@@ -0,0 +1,92 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QSet>
+#include <QSharedPointer>
+
+#include "Cache.h"
+#include "MatrixClient.h"
+#include "OutboundMessage.h"
+
+// Sends the messages of the user in the order they were written. Every
+// message is stored in the cache before it is sent and is only dropped when
+// the server accepts or rejects it, so nothing is lost on a flaky
+// connection or a restart.
+//
+// Each room has its own queue and only its oldest message is in flight, so
+// that a message that has to be retried can't end up after the ones that
+// were written later. A room that fails to send retries with an increasing
+// delay. The rooms are sent to in parallel.
+class Outbox : public QObject
+{
+        Q_OBJECT
+
+public:
+        Outbox(QSharedPointer<MatrixClient> client, QObject *parent = 0);
+
+        // Restore the messages that were queued when the client was closed
+        // and start sending them.
+        void setCache(QSharedPointer<Cache> cache);
+        void clear();
+
+        // Queue a message and return the transaction ID that was assigned to it.
+        int enqueue(const QString &room_id,
+                    matrix::events::MessageEventType ty,
+                    const QString &body,
+                    const QString &url = "");
+
+        // The messages of the room that aren't accepted yet, oldest first.
+        QList<OutboundMessage> messages(const QString &room_id) const;
+
+        // The message was found in the timeline, e.g the server accepted it
+        // but the client was closed before the reply arrived. It isn't sent
+        // again.
+        void confirm(const QString &room_id, int txn_id);
+
+signals:
+        // The server rejected the message and it won't be retried.
+        void messageFailed(const QString &room_id, int txn_id);
+
+private slots:
+        void messageSent(const QString &event_id, const QString &room_id, int txn_id);
+        void messageSendFailed(const QString &room_id, int txn_id, int status);
+
+private:
+        static const int MinRetryDelay = 1000;
+        static const int MaxRetryDelay = 60000;
+
+        // Send the oldest message of the room unless it's already in flight.
+        void dispatch(const QString &room_id);
+        void remove(const QString &room_id, int txn_id);
+        bool isInFlight(const QString &room_id, int txn_id) const;
+
+        QHash<QString, QList<OutboundMessage>> queues_;
+        // The transaction ID of the message of each room that is in flight.
+        QHash<QString, int> in_flight_;
+
+        // The rooms that wait for a retry and the delay of their next one.
+        QSet<QString> paused_;
+        QHash<QString, int> retry_delay_;
+
+        QSharedPointer<MatrixClient> client_;
+        QSharedPointer<Cache> cache_;
+};
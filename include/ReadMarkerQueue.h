@@ -0,0 +1,66 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QSharedPointer>
+#include <QTimer>
+
+#include "Cache.h"
+#include "MatrixClient.h"
+
+// Coalesces the read markers of the rooms. Switching rooms or scrolling only
+// records the newest event that was seen. At most one /read_markers request
+// per room is sent on each interval.
+//
+// A marker is kept in the cache until the server acknowledges it, so the
+// markers that were pending on exit are sent after the next start. A marker
+// that fails to be sent is queued again.
+class ReadMarkerQueue : public QObject
+{
+        Q_OBJECT
+
+public:
+        ReadMarkerQueue(QSharedPointer<MatrixClient> client, QObject *parent = 0);
+
+        // Restore the markers that were pending when the client was closed.
+        void setCache(QSharedPointer<Cache> cache);
+        void clear();
+
+public slots:
+        void markRead(const QString &room_id, const QString &event_id);
+
+private slots:
+        void flush();
+        void markerSent(const QString &room_id, const QString &event_id);
+        void markerFailed(const QString &room_id, const QString &event_id);
+
+private:
+        static const int FlushInterval = 3000;
+
+        // The newest marker of each room that isn't sent yet.
+        QHash<QString, QString> pending_;
+        // The last marker that was sent for each room.
+        QHash<QString, QString> sent_;
+
+        QTimer *timer_;
+
+        QSharedPointer<MatrixClient> client_;
+        QSharedPointer<Cache> cache_;
+};
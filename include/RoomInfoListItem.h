@@ -39,24 +39,22 @@ class RoomInfoListItem : public QWidget
 
 public:
         RoomInfoListItem(QSharedPointer<RoomSettings> settings,
-                         RoomState state,
+                         QSharedPointer<RoomState> state,
                          QString room_id,
                          QWidget *parent = 0);
 
         ~RoomInfoListItem();
 
-        void updateUnreadMessageCount(int count);
-        void clearUnreadMessageCount();
-        void setState(const RoomState &state);
+        void setUnreadMessageCount(int count);
 
         inline bool isPressed() const;
-        inline RoomState state() const;
         inline void setAvatar(const QImage &avatar_image);
         inline int unreadMessageCount() const;
         inline void setDescriptionMessage(const DescInfo &info);
 
 signals:
         void clicked(const QString &room_id);
+        void notificationsToggled(const QString &room_id);
 
 public slots:
         void setPressedState(bool state);
@@ -75,7 +73,8 @@ private:
 
         RippleOverlay *ripple_overlay_;
 
-        RoomState state_;
+        // Owned by the RoomRegistry and updated in place on every sync.
+        QSharedPointer<RoomState> state_;
 
         QString roomId_;
         QString roomName_;
@@ -107,12 +106,6 @@ RoomInfoListItem::isPressed() const
         return isPressed_;
 }
 
-inline RoomState
-RoomInfoListItem::state() const
-{
-        return state_;
-}
-
 inline void
 RoomInfoListItem::setAvatar(const QImage &img)
 {
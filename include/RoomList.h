@@ -24,7 +24,7 @@
 
 #include "MatrixClient.h"
 #include "RoomInfoListItem.h"
-#include "RoomState.h"
+#include "RoomRegistry.h"
 #include "Sync.h"
 
 class RoomList : public QWidget
@@ -32,34 +32,48 @@ class RoomList : public QWidget
         Q_OBJECT
 
 public:
-        RoomList(QSharedPointer<MatrixClient> client, QWidget *parent = 0);
+        RoomList(QSharedPointer<MatrixClient> client,
+                 QSharedPointer<RoomRegistry> registry,
+                 QWidget *parent = 0);
         ~RoomList();
 
-        void setInitialRooms(const QMap<QString, QSharedPointer<RoomSettings>> &settings,
-                             const QMap<QString, RoomState> &states);
-        void sync(const QMap<QString, RoomState> &states);
+        // Create an item for every room in the registry.
+        void setInitialRooms();
+
+        // Rooms joined or left after the initial sync.
+        void addRoom(RoomHandle room);
+        void removeRoom(RoomHandle room);
 
         void clear();
 
 signals:
         void roomChanged(const QString &room_id);
-        void totalUnreadMessageCountUpdated(int count);
 
 public slots:
         void updateRoomAvatar(const QString &roomid, const QPixmap &img);
         void highlightSelectedRoom(const QString &room_id);
-        void updateUnreadMessageCount(const QString &roomid, int count);
+        void updateUnreadNotifications(RoomHandle room, const UnreadNotifications &counts);
         void updateRoomDescription(const QString &roomid, const DescInfo &info);
 
+        // The room state itself is shared, these only refresh what depends on it.
+        void updateRoomName(RoomHandle room);
+        void updateRoomAvatarUrl(RoomHandle room, const QUrl &avatar_url);
+
 private:
-        void calculateUnreadMessageCount();
+        // Create the item of a room and append it to the list.
+        void createItem(RoomHandle room);
+
+        // The item of the room or null if the room isn't listed.
+        QSharedPointer<RoomInfoListItem> item(RoomHandle room) const;
 
         QVBoxLayout *topLayout_;
         QVBoxLayout *contentsLayout_;
         QScrollArea *scrollArea_;
         QWidget *scrollAreaContents_;
 
-        QMap<QString, QSharedPointer<RoomInfoListItem>> rooms_;
+        // Indexed by the room handle.
+        QVector<QSharedPointer<RoomInfoListItem>> rooms_;
 
         QSharedPointer<MatrixClient> client_;
+        QSharedPointer<RoomRegistry> registry_;
 };
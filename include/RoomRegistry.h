@@ -0,0 +1,169 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPixmap>
+#include <QSharedPointer>
+#include <QUrl>
+#include <QVector>
+
+#include "RoomSettings.h"
+#include "RoomState.h"
+#include "Sync.h"
+
+// Dense index of a room in the RoomRegistry. Handles are assigned in
+// insertion order and stay valid until the room is removed or the registry is
+// cleared. The handle of a removed room is never reused.
+using RoomHandle = int;
+
+// Owns the per-room data of every joined room. The room ID is translated to a
+// handle once, where it enters the client (sync responses, API replies, user
+// input) and everything else is indexed by the handle.
+//
+// Each RoomState is allocated once and shared with the widgets that display
+// it. Sync deltas are applied in place and only the properties that actually
+// changed are signaled.
+class RoomRegistry : public QObject
+{
+        Q_OBJECT
+
+public:
+        static const RoomHandle InvalidRoom = -1;
+
+        RoomRegistry(QObject *parent = 0);
+
+        // Take ownership of an already resolved room state. The settings of the
+        // room are created or restored at the same time.
+        RoomHandle insert(const QString &room_id, RoomState state);
+
+        // Merge the state and timeline events and the summary of a sync into the room.
+        void update(RoomHandle room, const JoinedRoom &data);
+
+        // Drop every component of the room. Its slot is left empty, so loops
+        // over [0, size()) should skip the rooms that aren't contained.
+        void remove(RoomHandle room);
+
+        void setAvatar(RoomHandle room, const QPixmap &img);
+
+        // Replace the counts of the room and adjust the total by the difference.
+        void setUnreadNotifications(RoomHandle room, const UnreadNotifications &counts);
+
+        // The room was muted or unmuted through its settings. The muted rooms
+        // don't count towards the total.
+        void notificationsToggled(RoomHandle room);
+
+        void clear();
+
+        // Returns InvalidRoom for rooms that aren't tracked.
+        inline RoomHandle handle(const QString &room_id) const;
+
+        inline bool contains(RoomHandle room) const;
+        inline bool isEmpty() const;
+        inline int size() const;
+
+        inline QString roomId(RoomHandle room) const;
+        inline QSharedPointer<RoomState> state(RoomHandle room) const;
+        inline QSharedPointer<RoomSettings> settings(RoomHandle room) const;
+        inline QPixmap avatar(RoomHandle room) const;
+        inline UnreadNotifications unreadNotifications(RoomHandle room) const;
+
+        // The sum of the counts of the rooms that aren't muted.
+        inline int totalNotificationCount() const;
+
+signals:
+        void nameChanged(RoomHandle room, const QString &name);
+        void topicChanged(RoomHandle room, const QString &topic);
+        void avatarChanged(RoomHandle room, const QUrl &avatar_url);
+        void membersChanged(RoomHandle room);
+        void unreadNotificationsChanged(RoomHandle room, const UnreadNotifications &counts);
+        void totalNotificationCountChanged(int count);
+
+private:
+        QHash<QString, RoomHandle> handles_;
+
+        // The components of each room, indexed by its handle.
+        QVector<QString> ids_;
+        QVector<QSharedPointer<RoomState>> states_;
+        QVector<QSharedPointer<RoomSettings>> settings_;
+        QVector<QPixmap> avatars_;
+        QVector<UnreadNotifications> unread_;
+
+        int total_notifications_ = 0;
+};
+
+inline RoomHandle
+RoomRegistry::handle(const QString &room_id) const
+{
+        return handles_.value(room_id, InvalidRoom);
+}
+
+inline bool
+RoomRegistry::contains(RoomHandle room) const
+{
+        return room >= 0 && room < ids_.size() && !states_[room].isNull();
+}
+
+inline bool
+RoomRegistry::isEmpty() const
+{
+        return handles_.isEmpty();
+}
+
+inline int
+RoomRegistry::size() const
+{
+        return ids_.size();
+}
+
+inline QString
+RoomRegistry::roomId(RoomHandle room) const
+{
+        return ids_.value(room);
+}
+
+inline QSharedPointer<RoomState>
+RoomRegistry::state(RoomHandle room) const
+{
+        return states_.value(room);
+}
+
+inline QSharedPointer<RoomSettings>
+RoomRegistry::settings(RoomHandle room) const
+{
+        return settings_.value(room);
+}
+
+inline QPixmap
+RoomRegistry::avatar(RoomHandle room) const
+{
+        return avatars_.value(room);
+}
+
+inline UnreadNotifications
+RoomRegistry::unreadNotifications(RoomHandle room) const
+{
+        return unread_.value(room);
+}
+
+inline int
+RoomRegistry::totalNotificationCount() const
+{
+        return total_notifications_;
+}
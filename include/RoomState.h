@@ -17,8 +17,10 @@
 
 #pragma once
 
+#include <QHash>
 #include <QJsonDocument>
 #include <QPixmap>
+#include <QSet>
 #include <QUrl>
 
 #include "AliasesEventContent.h"
@@ -32,7 +34,11 @@
 #include "PowerLevelsEventContent.h"
 #include "TopicEventContent.h"
 
+#include "DisplayNameIndex.h"
 #include "Event.h"
+#include "Identifier.h"
+#include "Instantiations.h"
+#include "RoomSummary.h"
 #include "RoomEvent.h"
 #include "StateEvent.h"
 
@@ -54,7 +60,9 @@ public:
 
         void removeLeaveMemberships();
         void update(const RoomState &state);
-        void updateFromEvents(const QJsonArray &events);
+
+        // Returns true if any of the events was a membership update.
+        bool updateFromEvents(const QJsonArray &events);
 
         QJsonObject serialize() const;
 
@@ -69,8 +77,19 @@ public:
         events::StateEvent<events::PowerLevelsEventContent> power_levels;
         events::StateEvent<events::TopicEventContent> topic;
 
-        // Contains the m.room.member events for all the joined users.
-        QMap<QString, events::StateEvent<events::MemberEventContent>> memberships;
+        // Contains the m.room.member events for all the joined users, keyed by user ID.
+        QHash<matrix::Identifier, events::StateEvent<events::MemberEventContent>> memberships;
+
+        // The members whose events changed since the state was last stored.
+        // Only their events are written to the cache.
+        QSet<matrix::Identifier> changed_members;
+
+        // The display names of the members. Updated along with the memberships
+        // and rebuilt from them when the state is loaded from the cache.
+        DisplayNameIndex display_names;
+
+        // The member counts and heroes. Updated along with the memberships.
+        RoomSummary summary;
 
 private:
         QUrl avatar_;
@@ -78,7 +97,7 @@ private:
 
         // It defines the user whose avatar is used for the room. If the room has an avatar
         // event this should be empty.
-        QString userAvatar_;
+        matrix::Identifier userAvatar_;
 };
 
 inline QString
@@ -0,0 +1,79 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QJsonObject>
+#include <QList>
+#include <QMap>
+#include <QString>
+
+#include "Identifier.h"
+#include "MemberEventContent.h"
+
+namespace events = matrix::events;
+
+class DisplayNameIndex;
+
+// The member counts and the heroes of a room, i.e the members used to name a
+// room that has no name or alias of its own.
+//
+// It is updated from membership transitions, so the members of the room are
+// never rescanned. The heroes are the joined or invited members other than
+// the local user, ordered by user ID so the result doesn't depend on the
+// order the events arrived. Summaries sent by the server take precedence
+// over the computed values while they are present.
+class RoomSummary
+{
+public:
+        // The maximum number of heroes, as in the specification.
+        static const int MaxHeroes = 5;
+
+        // The user excluded from the heroes. Set once after login.
+        static void setLocalUser(const matrix::Identifier &user_id);
+
+        // Record that a user went from the `previous` to the `current` membership.
+        // Users without a previous membership event should pass Leave.
+        void update(const matrix::Identifier &user_id,
+                    events::Membership previous,
+                    events::Membership current);
+
+        // Apply the `summary` object of a joined room from /sync.
+        void updateFromServer(const QJsonObject &summary);
+        // The fields that the server sent, in the same format. The rest is
+        // computed again from the members.
+        QJsonObject serialize() const;
+
+        // e.g "Alice", "Alice and Bob" or "Alice, Bob and 5 others".
+        QString name(const DisplayNameIndex &names) const;
+
+        QList<matrix::Identifier> heroes() const;
+        int joinedMemberCount() const;
+        int invitedMemberCount() const;
+
+private:
+        // Joined and invited members except the local user. Sorted by user ID.
+        QMap<QString, matrix::Identifier> members_;
+
+        int joined_  = 0;
+        int invited_ = 0;
+
+        // From the server. Negative counts are unset.
+        QList<matrix::Identifier> server_heroes_;
+        int server_joined_  = -1;
+        int server_invited_ = -1;
+};
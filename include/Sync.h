@@ -19,6 +19,7 @@
 
 #include <QJsonArray>
 #include <QJsonDocument>
+#include <QJsonObject>
 #include <QMap>
 #include <QString>
 
@@ -116,12 +117,13 @@ public:
         inline QString previousBatch() const;
         inline bool limited() const;
 
+        QJsonObject serialize() const;
         void deserialize(const QJsonValue &data) override;
 
 private:
         QJsonArray events_;
         QString prev_batch_;
-        bool limited_;
+        bool limited_ = false;
 };
 
 inline QJsonArray
@@ -142,21 +144,69 @@ Timeline::limited() const
         return limited_;
 }
 
-// TODO: Add support for ehpmeral, account_data, undread_notifications
+// The unread counts of a room, as computed by the server's push rules.
+class UnreadNotifications : public Deserializable
+{
+public:
+        inline int highlightCount() const;
+        inline int notificationCount() const;
+
+        inline bool operator==(const UnreadNotifications &other) const;
+        inline bool operator!=(const UnreadNotifications &other) const;
+
+        QJsonObject serialize() const;
+        void deserialize(const QJsonValue &data) override;
+
+private:
+        int highlight_count_    = 0;
+        int notification_count_ = 0;
+};
+
+inline int
+UnreadNotifications::highlightCount() const
+{
+        return highlight_count_;
+}
+
+inline int
+UnreadNotifications::notificationCount() const
+{
+        return notification_count_;
+}
+
+inline bool
+UnreadNotifications::operator==(const UnreadNotifications &other) const
+{
+        return highlight_count_ == other.highlight_count_ &&
+               notification_count_ == other.notification_count_;
+}
+
+inline bool
+UnreadNotifications::operator!=(const UnreadNotifications &other) const
+{
+        return !(*this == other);
+}
+
+// TODO: Add support for ehpmeral, account_data
 class JoinedRoom : public Deserializable
 {
 public:
         inline State state() const;
         inline Timeline timeline() const;
+        inline UnreadNotifications unreadNotifications() const;
+
+        // The room summary (heroes and member counts), if the server sent one.
+        inline QJsonObject summary() const;
 
         void deserialize(const QJsonValue &data) override;
 
 private:
         State state_;
         Timeline timeline_;
+        QJsonObject summary_;
+        UnreadNotifications unread_notifications_;
         /* Ephemeral ephemeral_; */
         /* AccountData account_data_; */
-        /* UnreadNotifications unread_notifications_; */
 };
 
 inline State
@@ -171,15 +221,74 @@ JoinedRoom::timeline() const
         return timeline_;
 }
 
-// TODO: Add support for invited and left rooms.
+inline UnreadNotifications
+JoinedRoom::unreadNotifications() const
+{
+        return unread_notifications_;
+}
+
+inline QJsonObject
+JoinedRoom::summary() const
+{
+        return summary_;
+}
+
+class InvitedRoom : public Deserializable
+{
+public:
+        // The stripped state events that describe the room.
+        inline QJsonArray inviteState() const;
+
+        void deserialize(const QJsonValue &data) override;
+
+private:
+        QJsonArray invite_state_;
+};
+
+inline QJsonArray
+InvitedRoom::inviteState() const
+{
+        return invite_state_;
+}
+
+class LeftRoom : public Deserializable
+{
+public:
+        inline State state() const;
+        inline Timeline timeline() const;
+
+        void deserialize(const QJsonValue &data) override;
+
+private:
+        State state_;
+        Timeline timeline_;
+};
+
+inline State
+LeftRoom::state() const
+{
+        return state_;
+}
+
+inline Timeline
+LeftRoom::timeline() const
+{
+        return timeline_;
+}
+
 class Rooms : public Deserializable
 {
 public:
         inline QMap<QString, JoinedRoom> join() const;
+        inline QMap<QString, InvitedRoom> invite() const;
+        inline QMap<QString, LeftRoom> leave() const;
+
         void deserialize(const QJsonValue &data) override;
 
 private:
         QMap<QString, JoinedRoom> join_;
+        QMap<QString, InvitedRoom> invite_;
+        QMap<QString, LeftRoom> leave_;
 };
 
 inline QMap<QString, JoinedRoom>
@@ -188,6 +297,18 @@ Rooms::join() const
         return join_;
 }
 
+inline QMap<QString, InvitedRoom>
+Rooms::invite() const
+{
+        return invite_;
+}
+
+inline QMap<QString, LeftRoom>
+Rooms::leave() const
+{
+        return leave_;
+}
+
 class SyncResponse : public Deserializable
 {
 public:
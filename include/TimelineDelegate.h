@@ -0,0 +1,174 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QCache>
+#include <QFont>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QPersistentModelIndex>
+#include <QPixmap>
+#include <QScopedPointer>
+#include <QSharedPointer>
+#include <QSize>
+#include <QStyledItemDelegate>
+#include <QTextDocument>
+#include <QUrl>
+
+#include "MatrixClient.h"
+#include "RoomState.h"
+#include "TimelineModel.h"
+
+// Paints the rows of a TimelineModel. Nothing is kept per row: the bodies are
+// parsed once into cached text layouts that are only reflowed on resize, and
+// only the images that were in view are downloaded and cached. The caches
+// share the memory budget of the room.
+class TimelineDelegate : public QStyledItemDelegate
+{
+        Q_OBJECT
+
+public:
+        TimelineDelegate(QSharedPointer<MatrixClient> client,
+                         QSharedPointer<RoomState> state,
+                         QObject *parent = 0);
+
+        void paint(QPainter *painter,
+                   const QStyleOptionViewItem &option,
+                   const QModelIndex &index) const override;
+        QSize sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const override;
+
+        // The link under the position. Images link to their download URL.
+        QUrl linkAt(const QStyleOptionViewItem &option,
+                    const QModelIndex &index,
+                    const QPoint &pos) const;
+
+        // Show an image (e.g a file that is being uploaded) without downloading it.
+        void setImage(const QString &url, const QPixmap &image);
+
+        // In KiB.
+        void setMemoryBudget(int budget);
+
+        // Release the images and the text layouts of the rows outside of the
+        // range. They are re-created from the entries when the rows are
+        // painted again.
+        void releaseRowsOutside(const TimelineModel *model, int first, int last);
+
+        // The emotes start with the display name of their sender, so their
+        // bodies are laid out again.
+        void displayNamesChanged(const TimelineModel *model);
+
+signals:
+        // The row has to be painted again, but its size didn't change.
+        void repaintNeeded(const QModelIndex &index);
+
+protected:
+        bool editorEvent(QEvent *event,
+                         QAbstractItemModel *model,
+                         const QStyleOptionViewItem &option,
+                         const QModelIndex &index) override;
+
+private slots:
+        void imageDownloaded(const QString &url, const QPixmap &image);
+
+private:
+        // The areas of a row, in view coordinates. The avatar area holds the
+        // timestamp of the rows without a sender.
+        struct RowLayout
+        {
+                QRect avatar;
+                QRect header;
+                QRect body;
+        };
+
+        // A body by its event (or its transaction while it's a local echo)
+        // and the key of the font.
+        using BodyKey = QPair<QString, QString>;
+
+        // The heights of a body by the widths it was laid out with.
+        using BodyHeights = QHash<int, int>;
+
+        RowLayout layoutRow(const QStyleOptionViewItem &option, const TimelineEntry &entry) const;
+
+        // Return the document of the body laid out for the width. It is owned
+        // by the delegate and is only valid until the next layout.
+        QTextDocument *layoutBody(const TimelineEntry &entry, int width) const;
+        int bodyHeight(const TimelineEntry &entry, int width) const;
+
+        BodyKey bodyKey(const TimelineEntry &entry) const;
+        QTextDocument *parseBody(const TimelineEntry &entry) const;
+
+        QString formatBody(const TimelineEntry &entry) const;
+        QString senderName(const TimelineEntry &entry) const;
+
+        void paintAvatar(QPainter *painter, const QRect &rect, const TimelineEntry &entry) const;
+        void paintGap(QPainter *painter, const QRect &rect, const TimelineEntry &entry) const;
+        void paintImage(QPainter *painter,
+                        const QStyleOptionViewItem &option,
+                        const QRect &rect,
+                        const QModelIndex &index) const;
+
+        // Return a null pixmap and start the download if the image isn't cached.
+        QPixmap image(const QModelIndex &index) const;
+        QSize imageSize(const TimelineEntry &entry) const;
+        QUrl downloadUrl(const QString &mxc_url) const;
+
+        static inline const TimelineEntry &entry(const QModelIndex &index);
+
+        static const int MaxImageWidth;
+        static const int MaxImageHeight;
+        // The strip with the file name that is shown over a hovered image.
+        static const int ImageTextHeight;
+        // In KiB, until the view sets the budget of the room.
+        static const int DefaultMemoryBudget;
+        // The bodies are laid out for widths rounded down to a multiple of
+        // the bucket, so that a resize only reflows them every few pixels.
+        static const int WidthBucket;
+        // In measured bodies.
+        static const int HeightCacheSize;
+
+        QFont font_;
+        QFont sender_font_;
+        QFont timestamp_font_;
+
+        // The parsed bodies, with the cost in KiB.
+        mutable QCache<BodyKey, QTextDocument> layouts_;
+        mutable QCache<BodyKey, BodyHeights> heights_;
+        // A body that doesn't fit in the budget at all.
+        mutable QScopedPointer<QTextDocument> uncached_layout_;
+
+        // The downloaded images by their mxc:// URL.
+        mutable QCache<QString, QPixmap> images_;
+        // The sizes of the images, which are kept when an image is released
+        // so that its row keeps its height. They go with the rows that no
+        // longer need them (see releaseRowsOutside).
+        QHash<QString, QSize> image_sizes_;
+        // The rows that wait for an image, by its mxc:// URL.
+        mutable QHash<QString, QList<QPersistentModelIndex>> requested_;
+
+        QSharedPointer<MatrixClient> client_;
+
+        // Used to resolve the display names of the senders.
+        QSharedPointer<RoomState> state_;
+};
+
+inline const TimelineEntry &
+TimelineDelegate::entry(const QModelIndex &index)
+{
+        return static_cast<const TimelineModel *>(index.model())->entry(index.row());
+}
@@ -0,0 +1,121 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QAbstractListModel>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QList>
+#include <QSize>
+#include <QString>
+
+#include "Identifier.h"
+
+// The data of one row of the timeline. Only what is needed to paint the row
+// is kept; the events themselves are dropped once parsed.
+struct TimelineEntry
+{
+        enum class Kind : quint8
+        {
+                Text,
+                Notice,
+                Emote,
+                Image,
+                // Events that were skipped by a limited sync.
+                Gap,
+        };
+
+        Kind kind = Kind::Text;
+
+        // Whether the row starts a group of messages from the same sender.
+        bool with_sender = false;
+        // A local echo that wasn't seen in a sync yet.
+        bool is_pending = false;
+        // A local echo that the server rejected.
+        bool is_failed = false;
+        // A gap whose page of events is being fetched.
+        bool is_fetching = false;
+
+        // The transaction ID of a message that was sent by this client, or -1.
+        // Only the sender receives it.
+        int txn_id = -1;
+
+        qint64 timestamp = 0;
+
+        matrix::Identifier sender;
+
+        // The event of the row. The newest event that is rendered below a gap.
+        QString event_id;
+
+        // The plain text of the message. The file name of an image.
+        QString body;
+
+        // The mxc:// URL of an image.
+        QString url;
+
+        // The size of an image, if the sender put it in the info of the
+        // event. The space of the image is reserved before it's downloaded.
+        QSize image_size;
+
+        // The token the missing events of a gap are fetched from.
+        QString prev_batch;
+};
+
+// The rows of the timeline of a room, oldest first. The rows are added in
+// batches so that the view lays out a page of events at once.
+class TimelineModel : public QAbstractListModel
+{
+        Q_OBJECT
+
+public:
+        TimelineModel(QObject *parent = 0);
+
+        int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+        QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+
+        inline const TimelineEntry &entry(int row) const;
+
+        // Fill the row of a message event. Return false for the events that
+        // aren't rendered.
+        static bool parseEntry(const QJsonObject &event, TimelineEntry &entry);
+
+        // Parse the rendered message events among the first `count` events,
+        // in the same order. It doesn't touch any view, so it is safe to run
+        // on a worker thread.
+        static QList<TimelineEntry> parseEntries(const QJsonArray &events, int count);
+
+        void append(const QList<TimelineEntry> &entries);
+        void prepend(const QList<TimelineEntry> &entries);
+        void insert(int row, const QList<TimelineEntry> &entries);
+        void remove(int row);
+
+        // Replace the entry of the row and repaint it.
+        void update(int row, const TimelineEntry &entry);
+
+        // The row of the newest message, or -1 if there are only gaps.
+        int lastMessageRow() const;
+
+private:
+        QList<TimelineEntry> entries_;
+};
+
+inline const TimelineEntry &
+TimelineModel::entry(int row) const
+{
+        return entries_.at(row);
+}
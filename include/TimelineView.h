@@ -17,18 +17,25 @@
 
 #pragma once
 
-#include <QHBoxLayout>
+#include <QElapsedTimer>
+#include <QHash>
 #include <QList>
-#include <QScrollArea>
+#include <QListView>
+#include <QPersistentModelIndex>
 #include <QVBoxLayout>
 #include <QWidget>
 
+#include "EventIdSet.h"
+#include "Identifier.h"
+#include "RoomState.h"
 #include "ScrollBar.h"
 #include "Sync.h"
-#include "TimelineItem.h"
+#include "TimelineDelegate.h"
+#include "TimelineModel.h"
 
 #include "Emote.h"
 #include "Image.h"
+#include "Instantiations.h"
 #include "MessageEvent.h"
 #include "Notice.h"
 #include "RoomInfoListItem.h"
@@ -37,24 +44,7 @@
 namespace msgs   = matrix::events::messages;
 namespace events = matrix::events;
 
-// Contains info about a message shown in the history view
-// but not yet confirmed by the homeserver through sync.
-struct PendingMessage {
-        int txn_id;
-        QString body;
-        QString event_id;
-        TimelineItem *widget;
-
-        PendingMessage(int txn_id, QString body, QString event_id, TimelineItem *widget)
-          : txn_id(txn_id)
-          , body(body)
-          , event_id(event_id)
-          , widget(widget)
-        {
-        }
-};
-
-// In which place new TimelineItems should be inserted.
+// In which place new rows should be inserted.
 enum class TimelineDirection {
         Top,
         Bottom,
@@ -67,96 +57,236 @@ class TimelineView : public QWidget
 public:
         TimelineView(const Timeline &timeline,
                      QSharedPointer<MatrixClient> client,
+                     QSharedPointer<RoomState> state,
                      const QString &room_id,
                      QWidget *parent = 0);
         TimelineView(QSharedPointer<MatrixClient> client,
+                     QSharedPointer<RoomState> state,
                      const QString &room_id,
                      QWidget *parent = 0);
 
-        TimelineItem *createTimelineItem(const events::MessageEvent<msgs::Image> &e,
-                                         bool with_sender);
-        TimelineItem *createTimelineItem(const events::MessageEvent<msgs::Notice> &e,
-                                         bool with_sender);
-        TimelineItem *createTimelineItem(const events::MessageEvent<msgs::Text> &e,
-                                         bool with_sender);
-        TimelineItem *createTimelineItem(const events::MessageEvent<msgs::Emote> &e,
-                                         bool with_sender);
-
-        // Add new events at the end of the timeline.
-        int addEvents(const Timeline &timeline);
+        // Add new events at the end of the timeline. The events are parsed
+        // on a worker thread first, like the pages of history.
+        void addEvents(const Timeline &timeline);
         void addUserMessage(matrix::events::MessageEventType ty, const QString &msg, int txn_id);
         void addUserMessage(const QString &url, const QString &filename, int txn_id);
         void updatePendingMessage(int txn_id, QString event_id);
+        // The server rejected the message. It stays in view, greyed out.
+        void markPendingMessageFailed(int txn_id);
         void scrollDown();
 
+        // Whether the newest messages are in view.
+        bool isScrolledToBottom() const;
+
+        // How many times, and for how long in total (ms), the user waited at
+        // the top of the timeline for a page of history.
+        inline int topWaits() const;
+        inline qint64 topWaitTime() const;
+
+        // The memory of the images and the text layouts of the room, in KiB.
+        void setMemoryBudget(int budget);
+
+        // Lay out the rows that show the display names of the members again.
+        void displayNamesChanged();
+        inline QString lastEventId() const;
+
+        // The summary of a message that is shown in the room list.
+        static DescInfo descriptionMessage(const TimelineEntry &entry,
+                                           const DisplayNameIndex &names,
+                                           const matrix::Identifier &local_user);
+
 public slots:
         void sliderRangeChanged(int min, int max);
         void sliderMoved(int position);
+
+        // Request the next page of history if the content above the viewport
+        // would run out before it arrives at the current scroll speed.
         void fetchHistory();
 
-        // Add old events at the top of the timeline.
+        // Start filling the gaps that are inside the viewport.
+        void fetchVisibleGaps();
+
+        // Add old events at the top of the timeline, or into the gap they were
+        // fetched for. The events are parsed on a worker thread first.
         void addBackwardsEvents(const QString &room_id, const RoomMessages &msgs);
 
+        // The page is requested again later, waiting longer after each failure.
+        // A gap is requested again when it's next in view.
+        void paginationFailed(const QString &room_id, const QString &from_token);
+
 signals:
         void updateLastTimelineMessage(const QString &user, const DescInfo &info);
+        void scrolledToBottom();
+
+protected:
+        bool eventFilter(QObject *obj, QEvent *event) override;
+
+private slots:
+        // Put the text of the selected messages in the clipboard.
+        void copySelection();
+
+        // Release what was rendered for the rows that are more than a few
+        // screens away from the viewport. The entries themselves are kept.
+        void releaseFarRows();
 
 private:
+        // A batch of a sync that waits for its events to be parsed.
+        struct SyncBatch
+        {
+                QJsonArray events;
+                // The gap above the events of a limited batch.
+                bool has_gap = false;
+                TimelineEntry gap;
+        };
+
         void init();
-        void addTimelineItem(TimelineItem *item, TimelineDirection direction);
-        void updateLastSender(const QString &user_id, TimelineDirection direction);
+        void requestHistory();
+
+        // Parse the oldest batch that is waiting on a worker thread.
+        void parseSyncBatch();
+        void appendSyncBatch(const SyncBatch &batch, const QList<TimelineEntry> &parsed);
+        void updateScrollVelocity(int position);
+        void addLocalEcho(const TimelineEntry &entry, int txn_id);
+
+        // Insert a page of rows and lay out the view once. The first row in
+        // view keeps its position, so inserting above it doesn't move the
+        // content. An empty view is scrolled to the bottom.
+        void insertPage(int row, const QList<TimelineEntry> &entries);
+        void updateLastSender(const matrix::Identifier &user_id, TimelineDirection direction);
         void notifyForLastEvent();
 
+        // Whether the page continues the history from the oldest row. Any
+        // other page would be inserted out of order.
+        bool isHistoryPage(const RoomMessages &msgs) const;
+        void addHistoryPage(const RoomMessages &msgs, const QList<TimelineEntry> &parsed);
+
+        // Render the page of events that belongs to the newest end of the gap.
+        // Only the first `missing` events of the page weren't rendered yet.
+        void fillGap(int row,
+                     const RoomMessages &msgs,
+                     int missing,
+                     const QList<TimelineEntry> &parsed);
+        int missingEvents(int gap_row, const QJsonArray &chunk) const;
+
+        // The row of the gap that is being filled from the token, or -1.
+        int findFetchingGap(const QString &prev_batch) const;
+
         // Used to determine whether or not we should prefix a message with the sender's name.
-        bool isSenderRendered(const QString &user_id, TimelineDirection direction);
+        bool isSenderRendered(const matrix::Identifier &user_id, TimelineDirection direction);
 
-        bool isPendingMessage(const QString &eventid,
-                              const QString &body,
-                              const QString &sender,
-                              const QString &userid);
-        void removePendingMessage(const QString &eventid, const QString &body);
+        // Whether the event is the server's copy of a local echo. The echo is
+        // kept in place and stops being pending.
+        bool confirmLocalEcho(const TimelineEntry &echo);
 
-        inline bool isDuplicate(const QString &event_id);
+        inline bool isDuplicate(const QString &event_id) const;
 
-        // Return nullptr if the event couldn't be parsed.
-        TimelineItem *parseMessageEvent(const QJsonObject &event, TimelineDirection direction);
+        // Return false if the parsed event isn't rendered as a new row: drop
+        // the duplicates and the local echoes and group the senders.
+        bool acceptEntry(TimelineEntry &entry, TimelineDirection direction);
 
         QVBoxLayout *top_layout_;
-        QVBoxLayout *scroll_layout_;
 
-        QScrollArea *scroll_area_;
+        QListView *list_;
         ScrollBar *scrollbar_;
-        QWidget *scroll_widget_;
 
-        QString lastSender_;
-        QString firstSender_;
+        TimelineModel *model_;
+        TimelineDelegate *delegate_;
+
+        matrix::Identifier lastSender_;
+        matrix::Identifier firstSender_;
         QString room_id_;
         QString prev_batch_token_;
-        QString local_user_;
+        // The newest event of the timeline regardless of its type.
+        QString last_event_id_;
+        matrix::Identifier local_user_;
 
         bool isPaginationInProgress_    = false;
         bool isInitialized              = false;
         bool isTimelineFinished         = false;
         bool isInitialSync              = true;
-        bool isPaginationScrollPending_ = false;
 
         const int SCROLL_BAR_GAP = 400;
 
-        QTimer *paginationTimer_;
+        // Scroll events further apart are different gestures (ms).
+        const int ScrollGestureTimeout = 250;
+
+        // How far from the viewport the rows stay rendered, in screens.
+        const int WindowScreens = 3;
+        // The rows are released once the scrolling settles (ms).
+        const int ReleaseDelay = 1000;
+
+        QTimer *release_timer_;
+
+        QElapsedTimer scroll_clock_;
+        qint64 last_scroll_time_  = 0;
+        int last_scroll_position_ = 0;
+        // Set while the rows move under a fixed viewport.
+        bool is_restoring_scroll_ = false;
+        // Towards the history, in pixels per millisecond.
+        double scroll_velocity_ = 0;
+
+        // Runs while a page of history is requested.
+        QElapsedTimer pagination_clock_;
+        // The round trip of a page (ms), until one is measured.
+        qint64 pagination_latency_ = 500;
+
+        // The delay before a failed page is requested again (ms).
+        const int MinRetryDelay = 1000;
+        const int MaxRetryDelay = 60000;
+
+        int retry_delay_ = MinRetryDelay;
+        QTimer *retry_timer_;
+
+        // Runs while the user waits at the top for the next page.
+        QElapsedTimer top_wait_clock_;
+        int top_waits_         = 0;
+        qint64 top_wait_total_ = 0;
 
         int scroll_height_       = 0;
         int previous_max_height_ = 0;
 
-        int oldPosition_;
-        int oldHeight_;
+        // The latest events that were rendered. Used for duplicate detection.
+        EventIdSet eventIds_;
+
+        // The local echoes of the messages that weren't seen in a sync yet,
+        // by their transaction ID. The event ID is known once the send
+        // request returns.
+        QHash<int, QPersistentModelIndex> pending_msgs_;
+        QHash<QString, int> pending_event_ids_;
+
+        // The rows of the gaps left by limited syncs, in no particular order.
+        QList<QPersistentModelIndex> gaps_;
+
+        // The batches of the syncs that are being parsed, oldest first.
+        QList<SyncBatch> sync_batches_;
 
-        // The events currently rendered. Used for duplicate detection.
-        QMap<QString, bool> eventIds_;
-        QList<PendingMessage> pending_msgs_;
         QSharedPointer<MatrixClient> client_;
+
+        // The state of the room, owned by the RoomRegistry. Used to resolve
+        // the display names of the senders.
+        QSharedPointer<RoomState> state_;
 };
 
+inline QString
+TimelineView::lastEventId() const
+{
+        return last_event_id_;
+}
+
+inline int
+TimelineView::topWaits() const
+{
+        return top_waits_;
+}
+
+inline qint64
+TimelineView::topWaitTime() const
+{
+        return top_wait_total_;
+}
+
 inline bool
-TimelineView::isDuplicate(const QString &event_id)
+TimelineView::isDuplicate(const QString &event_id) const
 {
         return eventIds_.contains(event_id);
 }
@@ -18,39 +18,57 @@
 #pragma once
 
 #include <QDebug>
+#include <QHash>
+#include <QList>
+#include <QSet>
 #include <QSharedPointer>
 #include <QStackedWidget>
 #include <QWidget>
 
+#include "Cache.h"
+#include "Identifier.h"
 #include "MatrixClient.h"
 #include "MessageEvent.h"
+#include "Outbox.h"
 #include "RoomInfoListItem.h"
+#include "RoomRegistry.h"
 #include "Sync.h"
 #include "TimelineView.h"
 
+// A view is created when its room is first shown, from the newest events in
+// the cache. Only the most recently shown rooms keep their views; the others
+// are rebuilt from the cache when they are shown again, with the scrollback
+// that fits in the tail the cache keeps.
 class TimelineViewManager : public QStackedWidget
 {
         Q_OBJECT
 
 public:
-        TimelineViewManager(QSharedPointer<MatrixClient> client, QWidget *parent);
+        TimelineViewManager(QSharedPointer<MatrixClient> client,
+                            QSharedPointer<RoomRegistry> registry,
+                            QSharedPointer<Outbox> outbox,
+                            QWidget *parent);
         ~TimelineViewManager();
 
-        // Initialize with timeline events.
+        void setCache(QSharedPointer<Cache> cache);
+
+        // Show the last message of the rooms of the initial sync.
         void initialize(const Rooms &rooms);
-        // Empty initialization.
+        // Show the last message of the rooms restored from the cache.
         void initialize(const QList<QString> &rooms);
-        void sync(const Rooms &rooms);
+        // Add the new timeline events of a synced room.
+        void sync(RoomHandle room, const Timeline &timeline);
+        // Rooms joined or left after the initial sync.
+        void addRoom(RoomHandle room, const Timeline &timeline);
+        void removeRoom(RoomHandle room);
         void clearAll();
 
         static QString chooseRandomColor();
-        static QString displayName(const QString &userid);
-
-        static QMap<QString, QString> DISPLAY_NAMES;
 
 signals:
-        void unreadMessages(QString roomid, int count);
         void updateRoomsLastMessage(const QString &user, const DescInfo &info);
+        // The user has seen the events of the room up to the given one.
+        void eventsRead(const QString &room_id, const QString &event_id);
 
 public slots:
         void setHistoryView(const QString &room_id);
@@ -60,9 +78,45 @@ public slots:
 
 private slots:
         void messageSent(const QString &eventid, const QString &roomid, int txnid);
+        void messageFailed(const QString &roomid, int txnid);
 
 private:
-        QString active_room_;
-        QMap<QString, QSharedPointer<TimelineView>> views_;
+        // The view of the room. It's created if the room doesn't have one and
+        // becomes the most recently used.
+        QSharedPointer<TimelineView> showView(RoomHandle room);
+        // The events of the restored timeline confirm the queued messages
+        // with the given transaction IDs.
+        void addView(RoomHandle room, TimelineView *view, const QSet<int> &restored_txn_ids);
+        void removeView(RoomHandle room);
+
+        // Mark the newest event as read if the room is on screen.
+        void markActiveRoomRead(RoomHandle room);
+
+        // Show the newest message of the batch in the room list.
+        void updateLastMessage(RoomHandle room, const Timeline &timeline);
+
+        // Split the memory budget between the views, from the settings.
+        void updateMemoryBudgets();
+
+        // The number of views that are kept alive.
+        static const int MaxViews;
+        // In MiB, unless timeline/room_memory_budget and
+        // timeline/memory_budget are set.
+        static const int DefaultRoomMemoryBudget;
+        static const int DefaultMemoryBudget;
+
+        RoomHandle active_room_ = RoomRegistry::InvalidRoom;
+
+        // Indexed by the room handle. Null for the rooms without a view.
+        QVector<QSharedPointer<TimelineView>> views_;
+
+        // The rooms with a view, the most recently shown first.
+        QList<RoomHandle> recent_rooms_;
+
+        matrix::Identifier local_user_;
+
         QSharedPointer<MatrixClient> client_;
+        QSharedPointer<RoomRegistry> registry_;
+        QSharedPointer<Outbox> outbox_;
+        QSharedPointer<Cache> cache_;
 };
@@ -51,6 +51,10 @@ public:
 
         void reset();
 
+signals:
+        // The notifications of the room were enabled or disabled.
+        void notificationsToggled();
+
 protected:
         void paintEvent(QPaintEvent *event) override;
 
@@ -67,10 +67,13 @@ class Event
   , public Serializable
 {
 public:
-        inline Content content() const;
+        inline const Content &content() const;
         inline EventType eventType() const;
 
+        // The JSON object is extracted once here and the object overload
+        // of the most derived event does the actual parsing.
         void deserialize(const QJsonValue &data) override;
+        void deserialize(const QJsonObject &object) override;
         QJsonObject serialize() const override;
 
 private:
@@ -79,7 +82,7 @@ private:
 };
 
 template<class Content>
-inline Content
+inline const Content &
 Event<Content>::content() const
 {
         return content_;
@@ -99,9 +102,14 @@ Event<Content>::deserialize(const QJsonValue &data)
         if (!data.isObject())
                 throw DeserializationException("Event is not a JSON object");
 
-        auto object = data.toObject();
+        deserialize(data.toObject());
+}
 
-        content_.deserialize(object.value("content"));
+template<class Content>
+void
+Event<Content>::deserialize(const QJsonObject &object)
+{
+        content_.deserialize(object.value(QStringLiteral("content")));
         type_ = extractEventType(object);
 }
 
@@ -0,0 +1,99 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "MessageEvent.h"
+#include "RoomEvent.h"
+#include "StateEvent.h"
+
+#include "AliasesEventContent.h"
+#include "AvatarEventContent.h"
+#include "CanonicalAliasEventContent.h"
+#include "CreateEventContent.h"
+#include "HistoryVisibilityEventContent.h"
+#include "JoinRulesEventContent.h"
+#include "MemberEventContent.h"
+#include "MessageEventContent.h"
+#include "NameEventContent.h"
+#include "PowerLevelsEventContent.h"
+#include "TopicEventContent.h"
+
+#include "Audio.h"
+#include "Emote.h"
+#include "File.h"
+#include "Image.h"
+#include "Location.h"
+#include "Notice.h"
+#include "Text.h"
+#include "Video.h"
+
+// The event templates for every content type in use are instantiated once in
+// src/events/Instantiations.cc. Including this header stops the other
+// translation units from emitting their own copies.
+//
+// Keep the list in sync with the definitions in Instantiations.cc.
+
+namespace matrix
+{
+namespace events
+{
+extern template class Event<AliasesEventContent>;
+extern template class Event<AvatarEventContent>;
+extern template class Event<CanonicalAliasEventContent>;
+extern template class Event<CreateEventContent>;
+extern template class Event<HistoryVisibilityEventContent>;
+extern template class Event<JoinRulesEventContent>;
+extern template class Event<MemberEventContent>;
+extern template class Event<MessageEventContent>;
+extern template class Event<NameEventContent>;
+extern template class Event<PowerLevelsEventContent>;
+extern template class Event<TopicEventContent>;
+
+extern template class RoomEvent<AliasesEventContent>;
+extern template class RoomEvent<AvatarEventContent>;
+extern template class RoomEvent<CanonicalAliasEventContent>;
+extern template class RoomEvent<CreateEventContent>;
+extern template class RoomEvent<HistoryVisibilityEventContent>;
+extern template class RoomEvent<JoinRulesEventContent>;
+extern template class RoomEvent<MemberEventContent>;
+extern template class RoomEvent<MessageEventContent>;
+extern template class RoomEvent<NameEventContent>;
+extern template class RoomEvent<PowerLevelsEventContent>;
+extern template class RoomEvent<TopicEventContent>;
+
+extern template class StateEvent<AliasesEventContent>;
+extern template class StateEvent<AvatarEventContent>;
+extern template class StateEvent<CanonicalAliasEventContent>;
+extern template class StateEvent<CreateEventContent>;
+extern template class StateEvent<HistoryVisibilityEventContent>;
+extern template class StateEvent<JoinRulesEventContent>;
+extern template class StateEvent<MemberEventContent>;
+extern template class StateEvent<NameEventContent>;
+extern template class StateEvent<PowerLevelsEventContent>;
+extern template class StateEvent<TopicEventContent>;
+
+extern template class MessageEvent<messages::Audio>;
+extern template class MessageEvent<messages::Emote>;
+extern template class MessageEvent<messages::File>;
+extern template class MessageEvent<messages::Image>;
+extern template class MessageEvent<messages::Location>;
+extern template class MessageEvent<messages::Notice>;
+extern template class MessageEvent<messages::Text>;
+extern template class MessageEvent<messages::Video>;
+} // namespace events
+} // namespace matrix
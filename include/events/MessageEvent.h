@@ -28,16 +28,18 @@ template<class MsgContent>
 class MessageEvent : public RoomEvent<MessageEventContent>
 {
 public:
-        inline MsgContent msgContent() const;
+        inline const MsgContent &msgContent() const;
 
-        void deserialize(const QJsonValue &data) override;
+        using RoomEvent<MessageEventContent>::deserialize;
+        void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         MsgContent msg_content_;
 };
 
 template<class MsgContent>
-inline MsgContent
+inline const MsgContent &
 MessageEvent<MsgContent>::msgContent() const
 {
         return msg_content_;
@@ -45,22 +47,53 @@ MessageEvent<MsgContent>::msgContent() const
 
 template<class MsgContent>
 void
-MessageEvent<MsgContent>::deserialize(const QJsonValue &data)
+MessageEvent<MsgContent>::deserialize(const QJsonObject &object)
 {
-        RoomEvent<MessageEventContent>::deserialize(data);
+        RoomEvent<MessageEventContent>::deserialize(object);
 
-        msg_content_.deserialize(data.toObject().value("content").toObject());
+        msg_content_.deserialize(object.value(QStringLiteral("content")).toObject());
+}
+
+template<class MsgContent>
+QJsonObject
+MessageEvent<MsgContent>::serialize() const
+{
+        QJsonObject object = RoomEvent<MessageEventContent>::serialize();
+
+        // The body comes from the common content, the rest from the message type.
+        auto content = object.value(QStringLiteral("content")).toObject();
+        auto msg     = msg_content_.serialize();
+
+        for (auto it = msg.constBegin(); it != msg.constEnd(); ++it)
+                content.insert(it.key(), it.value());
+
+        object["content"] = content;
+
+        return object;
 }
 
 namespace messages
 {
 struct ThumbnailInfo {
-        int h;
-        int w;
-        int size;
+        int h    = 0;
+        int w    = 0;
+        int size = 0;
 
         QString mimetype;
 };
+
+inline QJsonObject
+serializeThumbnailInfo(const ThumbnailInfo &info)
+{
+        QJsonObject object;
+
+        object["h"]        = info.h;
+        object["w"]        = info.w;
+        object["size"]     = info.size;
+        object["mimetype"] = info.mimetype;
+
+        return object;
+}
 } // namespace messages
 } // namespace events
 } // namespace matrix
@@ -21,6 +21,7 @@
 #include <QString>
 
 #include "Event.h"
+#include "Identifier.h"
 
 namespace matrix
 {
@@ -35,13 +36,18 @@ public:
         inline QString sender() const;
         inline uint64_t timestamp() const;
 
-        void deserialize(const QJsonValue &data) override;
+        // The interned form of the room and sender IDs.
+        inline Identifier roomHandle() const;
+        inline Identifier senderHandle() const;
+
+        using Event<Content>::deserialize;
+        void deserialize(const QJsonObject &object) override;
         QJsonObject serialize() const override;
 
 private:
         QString event_id_;
-        QString room_id_;
-        QString sender_;
+        Identifier room_id_;
+        Identifier sender_;
 
         uint64_t origin_server_ts_;
 };
@@ -57,14 +63,14 @@ template<class Content>
 inline QString
 RoomEvent<Content>::roomId() const
 {
-        return room_id_;
+        return room_id_.toString();
 }
 
 template<class Content>
 inline QString
 RoomEvent<Content>::sender() const
 {
-        return sender_;
+        return sender_.toString();
 }
 
 template<class Content>
@@ -74,31 +80,48 @@ RoomEvent<Content>::timestamp() const
         return origin_server_ts_;
 }
 
+template<class Content>
+inline Identifier
+RoomEvent<Content>::roomHandle() const
+{
+        return room_id_;
+}
+
+template<class Content>
+inline Identifier
+RoomEvent<Content>::senderHandle() const
+{
+        return sender_;
+}
+
 template<class Content>
 void
-RoomEvent<Content>::deserialize(const QJsonValue &data)
+RoomEvent<Content>::deserialize(const QJsonObject &object)
 {
-        Event<Content>::deserialize(data);
+        Event<Content>::deserialize(object);
 
-        auto object = data.toObject();
+        // Each key is looked up once; a missing key yields an undefined value.
+        const auto event_id         = object.value(QStringLiteral("event_id"));
+        const auto origin_server_ts = object.value(QStringLiteral("origin_server_ts"));
+        const auto sender           = object.value(QStringLiteral("sender"));
 
-        if (!object.contains("event_id"))
+        if (event_id.isUndefined())
                 throw DeserializationException("event_id key is missing");
 
-        if (!object.contains("origin_server_ts"))
+        if (origin_server_ts.isUndefined())
                 throw DeserializationException("origin_server_ts key is missing");
 
         // FIXME: Synapse doesn't include room id?!
         /* if (!object.contains("room_id")) */
         /* 	throw DeserializationException("room_id key is missing"); */
 
-        if (!object.contains("sender"))
+        if (sender.isUndefined())
                 throw DeserializationException("sender key is missing");
 
-        event_id_         = object.value("event_id").toString();
-        room_id_          = object.value("room_id").toString();
-        sender_           = object.value("sender").toString();
-        origin_server_ts_ = object.value("origin_server_ts").toDouble();
+        event_id_         = event_id.toString();
+        room_id_          = Identifier(object.value(QStringLiteral("room_id")).toString());
+        sender_           = Identifier(sender.toString());
+        origin_server_ts_ = origin_server_ts.toDouble();
 }
 
 template<class Content>
@@ -108,8 +131,8 @@ RoomEvent<Content>::serialize() const
         QJsonObject object = Event<Content>::serialize();
 
         object["event_id"]         = event_id_;
-        object["room_id"]          = room_id_;
-        object["sender"]           = sender_;
+        object["room_id"]          = room_id_.toString();
+        object["sender"]           = sender_.toString();
         object["origin_server_ts"] = QJsonValue(static_cast<qint64>(origin_server_ts_));
 
         return object;
@@ -30,13 +30,17 @@ class StateEvent : public RoomEvent<Content>
 {
 public:
         inline QString stateKey() const;
-        inline Content previousContent() const;
+        inline const Content &previousContent() const;
 
-        void deserialize(const QJsonValue &data);
-        QJsonObject serialize() const;
+        // The interned form of the state key.
+        inline Identifier stateKeyHandle() const;
+
+        using RoomEvent<Content>::deserialize;
+        void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
-        QString state_key_;
+        Identifier state_key_;
         Content prev_content_;
 };
 
@@ -44,31 +48,40 @@ template<class Content>
 inline QString
 StateEvent<Content>::stateKey() const
 {
-        return state_key_;
+        return state_key_.toString();
 }
 
 template<class Content>
-inline Content
+inline const Content &
 StateEvent<Content>::previousContent() const
 {
         return prev_content_;
 }
 
+template<class Content>
+inline Identifier
+StateEvent<Content>::stateKeyHandle() const
+{
+        return state_key_;
+}
+
 template<class Content>
 void
-StateEvent<Content>::deserialize(const QJsonValue &data)
+StateEvent<Content>::deserialize(const QJsonObject &object)
 {
-        RoomEvent<Content>::deserialize(data);
+        RoomEvent<Content>::deserialize(object);
 
-        auto object = data.toObject();
+        const auto state_key = object.value(QStringLiteral("state_key"));
 
-        if (!object.contains("state_key"))
+        if (state_key.isUndefined())
                 throw DeserializationException("state_key key is missing");
 
-        state_key_ = object.value("state_key").toString();
+        state_key_ = Identifier(state_key.toString());
+
+        const auto prev_content = object.value(QStringLiteral("prev_content"));
 
-        if (object.contains("prev_content"))
-                prev_content_.deserialize(object.value("prev_content"));
+        if (!prev_content.isUndefined())
+                prev_content_.deserialize(prev_content);
 }
 
 template<class Content>
@@ -77,7 +90,7 @@ StateEvent<Content>::serialize() const
 {
         QJsonObject object = RoomEvent<Content>::serialize();
 
-        object["state_key"] = state_key_;
+        object["state_key"] = state_key_.toString();
 
         auto prev = prev_content_.serialize();
 
@@ -28,19 +28,22 @@ namespace events
 namespace messages
 {
 struct AudioInfo {
-        uint64_t duration;
-        int size;
+        uint64_t duration = 0;
+        int size          = 0;
 
         QString mimetype;
 };
 
-class Audio : public Deserializable
+class Audio
+  : public Deserializable
+  , public Serializable
 {
 public:
         inline QString url() const;
         inline AudioInfo info() const;
 
         void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         QString url_;
@@ -29,14 +29,16 @@ namespace events
 namespace messages
 {
 struct FileInfo {
-        int size;
+        int size = 0;
 
         QString mimetype;
         QString thumbnail_url;
         ThumbnailInfo thumbnail_info;
 };
 
-class File : public Deserializable
+class File
+  : public Deserializable
+  , public Serializable
 {
 public:
         inline QString url() const;
@@ -45,6 +47,7 @@ public:
         inline FileInfo info() const;
 
         void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         QString url_;
@@ -29,22 +29,25 @@ namespace events
 namespace messages
 {
 struct ImageInfo {
-        int h;
-        int w;
-        int size;
+        int h    = 0;
+        int w    = 0;
+        int size = 0;
 
         QString mimetype;
         QString thumbnail_url;
         ThumbnailInfo thumbnail_info;
 };
 
-class Image : public Deserializable
+class Image
+  : public Deserializable
+  , public Serializable
 {
 public:
         inline QString url() const;
         inline ImageInfo info() const;
 
         void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         QString url_;
@@ -33,13 +33,16 @@ struct LocationInfo {
         ThumbnailInfo thumbnail_info;
 };
 
-class Location : public Deserializable
+class Location
+  : public Deserializable
+  , public Serializable
 {
 public:
         inline QString geoUri() const;
         inline LocationInfo info() const;
 
         void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         QString geo_uri_;
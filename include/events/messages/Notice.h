@@ -27,10 +27,13 @@ namespace events
 {
 namespace messages
 {
-class Notice : public Deserializable
+class Notice
+  : public Deserializable
+  , public Serializable
 {
 public:
         void deserialize(const QJsonObject &obj) override;
+        QJsonObject serialize() const override;
 };
 } // namespace messages
 } // namespace events
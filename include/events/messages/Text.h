@@ -27,10 +27,13 @@ namespace events
 {
 namespace messages
 {
-class Text : public Deserializable
+class Text
+  : public Deserializable
+  , public Serializable
 {
 public:
         void deserialize(const QJsonObject &obj) override;
+        QJsonObject serialize() const override;
 };
 } // namespace messages
 } // namespace events
@@ -29,23 +29,26 @@ namespace events
 namespace messages
 {
 struct VideoInfo {
-        int h;
-        int w;
-        int size;
-        int duration;
+        int h        = 0;
+        int w        = 0;
+        int size     = 0;
+        int duration = 0;
 
         QString mimetype;
         QString thumbnail_url;
         ThumbnailInfo thumbnail_info;
 };
 
-class Video : public Deserializable
+class Video
+  : public Deserializable
+  , public Serializable
 {
 public:
         inline QString url() const;
         inline VideoInfo info() const;
 
         void deserialize(const QJsonObject &object) override;
+        QJsonObject serialize() const override;
 
 private:
         QString url_;
@@ -18,8 +18,8 @@
 #pragma once
 
 #include <QGraphicsOpacityEffect>
+#include <QAbstractScrollArea>
 #include <QPainter>
-#include <QScrollArea>
 #include <QScrollBar>
 #include <QTimer>
 
@@ -27,7 +27,7 @@ class ScrollBar : public QScrollBar
 {
         Q_OBJECT
 public:
-        ScrollBar(QScrollArea *area, QWidget *parent = nullptr);
+        ScrollBar(QAbstractScrollArea *area, QWidget *parent = nullptr);
 
         void fadeIn();
         void fadeOut();
@@ -48,6 +48,6 @@ private:
         QGraphicsOpacityEffect *eff;
         QTimer hideTimer_;
 
-        QScrollArea *area_;
+        QAbstractScrollArea *area_;
         QRect handle_;
 };
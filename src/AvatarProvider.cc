@@ -19,9 +19,9 @@
 
 QSharedPointer<MatrixClient> AvatarProvider::client_;
 
-QMap<QString, QImage> AvatarProvider::userAvatars_;
-QMap<QString, QUrl> AvatarProvider::avatarUrls_;
-QMap<QString, QList<TimelineItem *>> AvatarProvider::toBeResolved_;
+QHash<matrix::Identifier, QImage> AvatarProvider::userAvatars_;
+QHash<matrix::Identifier, QUrl> AvatarProvider::avatarUrls_;
+QSet<matrix::Identifier> AvatarProvider::requested_;
 
 void
 AvatarProvider::init(QSharedPointer<MatrixClient> client)
@@ -32,49 +32,30 @@ AvatarProvider::init(QSharedPointer<MatrixClient> client)
 }
 
 void
-AvatarProvider::updateAvatar(const QString &uid, const QImage &img)
+AvatarProvider::updateAvatar(const QString &userId, const QImage &img)
 {
-        if (toBeResolved_.contains(uid)) {
-                auto items = toBeResolved_[uid];
-
-                // Update all the timeline items with the resolved avatar.
-                for (const auto item : items)
-                        item->setUserAvatar(img);
-
-                toBeResolved_.remove(uid);
-        }
+        auto uid = matrix::Identifier(userId);
 
+        requested_.remove(uid);
         userAvatars_.insert(uid, img);
 }
 
-void
-AvatarProvider::resolve(const QString &userId, TimelineItem *item)
+QImage
+AvatarProvider::avatar(const matrix::Identifier &userId)
 {
-        if (userAvatars_.contains(userId)) {
-                auto img = userAvatars_[userId];
+        if (userAvatars_.contains(userId))
+                return userAvatars_[userId];
 
-                item->setUserAvatar(img);
-
-                return;
+        if (avatarUrls_.contains(userId) && !requested_.contains(userId)) {
+                client_->fetchUserAvatar(userId.toString(), avatarUrls_[userId]);
+                requested_.insert(userId);
         }
 
-        if (avatarUrls_.contains(userId)) {
-                // Add the current timeline item to the waiting list for this avatar.
-                if (!toBeResolved_.contains(userId)) {
-                        client_->fetchUserAvatar(userId, avatarUrls_[userId]);
-
-                        QList<TimelineItem *> timelineItems;
-                        timelineItems.push_back(item);
-
-                        toBeResolved_.insert(userId, timelineItems);
-                } else {
-                        toBeResolved_[userId].push_back(item);
-                }
-        }
+        return QImage();
 }
 
 void
-AvatarProvider::setAvatarUrl(const QString &userId, const QUrl &url)
+AvatarProvider::setAvatarUrl(const matrix::Identifier &userId, const QUrl &url)
 {
         avatarUrls_.insert(userId, url);
 }
@@ -84,5 +65,5 @@ AvatarProvider::clear()
 {
         userAvatars_.clear();
         avatarUrls_.clear();
-        toBeResolved_.clear();
+        requested_.clear();
 }
@@ -0,0 +1,164 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QLatin1String>
+
+#include "BodyFormatter.h"
+#include "Config.h"
+
+static const QString EMOJI_OPEN =
+  QString("<span style=\"font-family: Emoji One; font-size: %1px\">").arg(conf::emojiSize);
+static const QLatin1String EMOJI_CLOSE("</span>");
+
+static const QLatin1String LINK_OPEN("<a href=\"");
+static const QLatin1String LINK_STYLE("\" style=\"color: #333333\">");
+static const QLatin1String LINK_CLOSE("</a>");
+
+static const QLatin1String URL_SCHEMES[] = {
+        QLatin1String("http://"), QLatin1String("https://"), QLatin1String("ftp://"),
+};
+
+// TODO: Be more precise here.
+static inline bool
+isEmoji(QChar c)
+{
+        return c.unicode() > 9000;
+}
+
+static inline void
+appendEscaped(QString &html, QChar c)
+{
+        switch (c.unicode()) {
+        case '<':
+                html += QLatin1String("&lt;");
+                break;
+        case '>':
+                html += QLatin1String("&gt;");
+                break;
+        case '&':
+                html += QLatin1String("&amp;");
+                break;
+        case '"':
+                html += QLatin1String("&quot;");
+                break;
+        default:
+                html += c;
+        }
+}
+
+// Escape a character of the text, opening or closing a run of emoji.
+static inline void
+appendText(QString &html, QChar c, bool &in_emoji)
+{
+        const bool emoji = isEmoji(c);
+
+        if (emoji != in_emoji) {
+                if (emoji)
+                        html += EMOJI_OPEN;
+                else
+                        html += EMOJI_CLOSE;
+
+                in_emoji = emoji;
+        }
+
+        appendEscaped(html, c);
+}
+
+// The length of the URL that starts at the character, or 0. A URL runs until
+// the next whitespace.
+static int
+urlLength(const QChar *begin, const QChar *end)
+{
+        for (const auto &scheme : URL_SCHEMES) {
+                const int size = scheme.size();
+
+                // There must be something after the scheme.
+                if (end - begin <= size)
+                        continue;
+
+                int i = 0;
+                while (i < size && begin[i] == QLatin1Char(scheme.data()[i]))
+                        ++i;
+
+                if (i < size || begin[size].isSpace())
+                        continue;
+
+                auto c = begin + size;
+                while (c != end && !c->isSpace())
+                        ++c;
+
+                return c - begin;
+        }
+
+        return 0;
+}
+
+static void
+appendLink(QString &html, const QChar *begin, const QChar *end)
+{
+        html += LINK_OPEN;
+
+        for (auto c = begin; c != end; ++c)
+                appendEscaped(html, *c);
+
+        html += LINK_STYLE;
+
+        bool in_emoji = false;
+
+        for (auto c = begin; c != end; ++c)
+                appendText(html, *c, in_emoji);
+
+        if (in_emoji)
+                html += EMOJI_CLOSE;
+
+        html += LINK_CLOSE;
+}
+
+void
+appendBodyHtml(QString &html, const QString &body)
+{
+        // Most bodies are plain text, with a few characters to escape.
+        html.reserve(html.size() + body.size() + body.size() / 2 + 64);
+
+        const QChar *c   = body.constData();
+        const QChar *end = c + body.size();
+
+        bool in_emoji = false;
+
+        while (c != end) {
+                // Only the schemes are worth checking.
+                const bool maybe_url = c->unicode() == 'h' || c->unicode() == 'f';
+                const int url_length = maybe_url ? urlLength(c, end) : 0;
+
+                if (url_length == 0) {
+                        appendText(html, *c, in_emoji);
+                        ++c;
+                        continue;
+                }
+
+                if (in_emoji) {
+                        html += EMOJI_CLOSE;
+                        in_emoji = false;
+                }
+
+                appendLink(html, c, c + url_length);
+                c += url_length;
+        }
+
+        if (in_emoji)
+                html += EMOJI_CLOSE;
+}
@@ -16,6 +16,7 @@
  */
 
 #include <stdexcept>
+#include <utility>
 
 #include <QDebug>
 #include <QDir>
@@ -30,10 +31,47 @@ namespace events = matrix::events;
 static const lmdb::val NEXT_BATCH_KEY("next_batch");
 static const lmdb::val transactionID("transaction_id");
 
+const int Cache::TimelineTailSize = 200;
+
+// The batches of a stored timeline, oldest first.
+static QJsonArray
+parseBatches(const QByteArray &data)
+{
+        auto object = QJsonDocument::fromBinaryData(data).object();
+
+        // Caches written before more than one batch was kept.
+        if (!object.contains("batches"))
+                return QJsonArray{ object };
+
+        return object.value("batches").toArray();
+}
+
+static int
+eventCount(const QJsonArray &batches)
+{
+        int count = 0;
+
+        for (const auto &batch : batches)
+                count += batch.toObject().value("events").toArray().size();
+
+        return count;
+}
+
+// Zero padded, so the keys of the outbox sort like the IDs.
+static QByteArray
+outboxKey(int txn_id)
+{
+        return QString("%1").arg(txn_id, 10, 10, QChar('0')).toUtf8();
+}
+
 Cache::Cache(const QString &userId)
   : env_{ nullptr }
   , stateDb_{ 0 }
   , roomDb_{ 0 }
+  , unreadDb_{ 0 }
+  , readMarkersDb_{ 0 }
+  , outboxDb_{ 0 }
+  , timelineDb_{ 0 }
   , isMounted_{ false }
   , userId_{ userId }
 {
@@ -78,8 +116,12 @@ Cache::Cache(const QString &userId)
         }
 
         auto txn = lmdb::txn::begin(env_);
-        stateDb_ = lmdb::dbi::open(txn, "state", MDB_CREATE);
-        roomDb_  = lmdb::dbi::open(txn, "rooms", MDB_CREATE);
+        stateDb_       = lmdb::dbi::open(txn, "state", MDB_CREATE);
+        roomDb_        = lmdb::dbi::open(txn, "rooms", MDB_CREATE);
+        unreadDb_      = lmdb::dbi::open(txn, "unread", MDB_CREATE);
+        readMarkersDb_ = lmdb::dbi::open(txn, "read_markers", MDB_CREATE);
+        outboxDb_      = lmdb::dbi::open(txn, "outbox", MDB_CREATE);
+        timelineDb_    = lmdb::dbi::open(txn, "timelines", MDB_CREATE);
 
         txn.commit();
 
@@ -90,7 +132,23 @@ Cache::Cache(const QString &userId)
 }
 
 void
-Cache::setState(const QString &nextBatchToken, const QMap<QString, RoomState> &states)
+Cache::setState(const QString &nextBatchToken, const RoomRegistry &registry)
+{
+        QVector<RoomHandle> rooms;
+        rooms.reserve(registry.size());
+
+        for (RoomHandle room = 0; room < registry.size(); ++room) {
+                if (registry.contains(room))
+                        rooms.append(room);
+        }
+
+        setState(nextBatchToken, registry, rooms);
+}
+
+void
+Cache::setState(const QString &nextBatchToken,
+                const RoomRegistry &registry,
+                const QVector<RoomHandle> &rooms)
 {
         if (!isMounted_)
                 return;
@@ -99,14 +157,205 @@ Cache::setState(const QString &nextBatchToken, const QMap<QString, RoomState> &s
 
         setNextBatchToken(txn, nextBatchToken);
 
-        for (auto it = states.constBegin(); it != states.constEnd(); it++)
-                insertRoomState(txn, it.key(), it.value());
+        for (const auto &room : rooms) {
+                auto id     = registry.roomId(room).toUtf8();
+                auto unread = QJsonDocument(registry.unreadNotifications(room).serialize())
+                                .toBinaryData();
+
+                insertRoomState(txn, registry.roomId(room), *registry.state(room));
+
+                lmdb::dbi_put(txn,
+                              unreadDb_,
+                              lmdb::val(id.data(), id.size()),
+                              lmdb::val(unread.data(), unread.size()));
+        }
+
+        txn.commit();
+}
+
+void
+Cache::removeRoom(const QString &roomid)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn = lmdb::txn::begin(env_);
+        auto id  = roomid.toUtf8();
+
+        lmdb::dbi_del(txn, roomDb_, lmdb::val(id.data(), id.size()), nullptr);
+        lmdb::dbi_del(txn, unreadDb_, lmdb::val(id.data(), id.size()), nullptr);
+        lmdb::dbi_del(txn, readMarkersDb_, lmdb::val(id.data(), id.size()), nullptr);
+        lmdb::dbi_del(txn, timelineDb_, lmdb::val(id.data(), id.size()), nullptr);
+
+        auto membersDb = lmdb::dbi::open(txn, roomid.toStdString().c_str(), MDB_CREATE);
+        lmdb::dbi_drop(txn, membersDb, true);
+
+        txn.commit();
+}
+
+void
+Cache::saveTimelines(const QMap<QString, Timeline> &timelines)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn = lmdb::txn::begin(env_);
+
+        for (auto it = timelines.constBegin(); it != timelines.constEnd(); it++) {
+                if (it.value().events().isEmpty())
+                        continue;
+
+                auto id = it.key().toUtf8();
+
+                // A limited batch keeps its flag. The timeline that is rebuilt
+                // from the tail has a gap from its token below the event
+                // before it.
+                auto batches = timelineBatches(txn, id);
+                batches.append(it.value().serialize());
+
+                int count = eventCount(batches);
+
+                while (batches.size() > 1 && count > TimelineTailSize) {
+                        count -= batches.first().toObject().value("events").toArray().size();
+                        batches.removeFirst();
+                }
+
+                setTimelineBatches(txn, id, batches);
+        }
+
+        txn.commit();
+}
+
+void
+Cache::saveHistory(const QString &roomid, const RoomMessages &msgs)
+{
+        if (!isMounted_ || msgs.chunk().isEmpty())
+                return;
+
+        auto txn     = lmdb::txn::begin(env_);
+        auto id      = roomid.toUtf8();
+        auto batches = timelineBatches(txn, id);
+
+        if (batches.isEmpty() || eventCount(batches) + msgs.chunk().size() > TimelineTailSize) {
+                txn.commit();
+                return;
+        }
+
+        auto first = batches.first().toObject();
+
+        // e.g the page of a gap.
+        if (first.value("prev_batch").toString() != msgs.start()) {
+                txn.commit();
+                return;
+        }
+
+        // The page is contiguous with the oldest batch.
+        first["limited"] = false;
+        batches.replace(0, first);
+
+        // The chunk starts with the newest event.
+        QJsonArray events;
+        for (int ii = msgs.chunk().size() - 1; ii >= 0; --ii)
+                events.append(msgs.chunk().at(ii));
+
+        batches.prepend(QJsonObject{
+          { "events", events }, { "prev_batch", msgs.end() }, { "limited", false } });
+
+        setTimelineBatches(txn, id, batches);
 
         txn.commit();
 }
 
+QList<Timeline>
+Cache::timeline(const QString &roomid)
+{
+        QList<Timeline> timeline;
+
+        if (!isMounted_)
+                return timeline;
+
+        auto txn     = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+        auto batches = timelineBatches(txn, roomid.toUtf8());
+
+        txn.commit();
+
+        for (const auto &data : batches) {
+                Timeline batch;
+
+                try {
+                        batch.deserialize(data);
+                } catch (const DeserializationException &e) {
+                        qWarning() << "Invalid timeline for" << roomid << e.what();
+                        return QList<Timeline>();
+                }
+
+                timeline.append(batch);
+        }
+
+        return timeline;
+}
+
+QJsonArray
+Cache::timelineBatches(lmdb::txn &txn, const QByteArray &roomid)
+{
+        lmdb::val data;
+
+        if (!lmdb::dbi_get(txn, timelineDb_, lmdb::val(roomid.data(), roomid.size()), data))
+                return QJsonArray();
+
+        return parseBatches(QByteArray(data.data(), data.size()));
+}
+
 void
-Cache::insertRoomState(lmdb::txn &txn, const QString &roomid, const RoomState &state)
+Cache::setTimelineBatches(lmdb::txn &txn, const QByteArray &roomid, const QJsonArray &batches)
+{
+        auto data = QJsonDocument(QJsonObject{ { "batches", batches } }).toBinaryData();
+
+        lmdb::dbi_put(txn,
+                      timelineDb_,
+                      lmdb::val(roomid.data(), roomid.size()),
+                      lmdb::val(data.data(), data.size()));
+}
+
+QMap<QString, Timeline>
+Cache::timelines()
+{
+        QMap<QString, Timeline> timelines;
+
+        auto txn    = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+        auto cursor = lmdb::cursor::open(txn, timelineDb_);
+
+        std::string room;
+        std::string data;
+
+        while (cursor.get(room, data, MDB_NEXT)) {
+                auto roomid  = QString::fromUtf8(room.data(), room.size());
+                auto batches = parseBatches(QByteArray(data.data(), data.size()));
+
+                if (batches.isEmpty())
+                        continue;
+
+                Timeline timeline;
+
+                try {
+                        timeline.deserialize(batches.last());
+                } catch (const DeserializationException &e) {
+                        qWarning() << "Invalid timeline for" << roomid << e.what();
+                        continue;
+                }
+
+                timelines.insert(roomid, timeline);
+        }
+
+        cursor.close();
+
+        txn.commit();
+
+        return timelines;
+}
+
+void
+Cache::insertRoomState(lmdb::txn &txn, const QString &roomid, RoomState &state)
 {
         auto stateEvents = QJsonDocument(state.serialize()).toBinaryData();
         auto id          = roomid.toUtf8();
@@ -116,14 +365,23 @@ Cache::insertRoomState(lmdb::txn &txn, const QString &roomid, const RoomState &s
                       lmdb::val(id.data(), id.size()),
                       lmdb::val(stateEvents.data(), stateEvents.size()));
 
-        for (const auto &membership : state.memberships) {
-                lmdb::dbi membersDb =
-                  lmdb::dbi::open(txn, roomid.toStdString().c_str(), MDB_CREATE);
+        lmdb::dbi membersDb = lmdb::dbi::open(txn, roomid.toStdString().c_str(), MDB_CREATE);
 
+        for (const auto &user_id : state.changed_members) {
                 // The user_id this membership event relates to, is used
                 // as the index on the membership database.
-                auto key         = membership.stateKey().toUtf8();
-                auto memberEvent = QJsonDocument(membership.serialize()).toBinaryData();
+                auto key = user_id.toString().toUtf8();
+
+                auto it = state.memberships.constFind(user_id);
+
+                // The leave events are dropped from the state once applied.
+                if (it == state.memberships.constEnd()) {
+                        lmdb::dbi_del(txn, membersDb, lmdb::val(key.data(), key.size()), nullptr);
+                        continue;
+                }
+
+                const auto &membership = it.value();
+                auto memberEvent       = QJsonDocument(membership.serialize()).toBinaryData();
 
                 switch (membership.content().membershipState()) {
                 // We add or update (e.g invite -> join) a new user to the membership list.
@@ -150,6 +408,8 @@ Cache::insertRoomState(lmdb::txn &txn, const QString &roomid, const RoomState &s
                 }
                 }
         }
+
+        state.changed_members.clear();
 }
 
 QMap<QString, RoomState>
@@ -173,7 +433,7 @@ Cache::states()
                 state.parse(json.object());
 
                 auto memberDb = lmdb::dbi::open(txn, roomid.toStdString().c_str(), MDB_CREATE);
-                QMap<QString, events::StateEvent<events::MemberEventContent>> members;
+                QHash<matrix::Identifier, events::StateEvent<events::MemberEventContent>> members;
 
                 auto memberCursor = lmdb::cursor::open(txn, memberDb);
 
@@ -188,7 +448,7 @@ Cache::states()
                         try {
                                 events::StateEvent<events::MemberEventContent> member;
                                 member.deserialize(data.object());
-                                members.insert(userid, member);
+                                members.insert(matrix::Identifier(userid), member);
                         } catch (const DeserializationException &e) {
                                 qWarning() << e.what();
                                 qWarning() << "Fault while parsing member event" << data.object();
@@ -198,7 +458,18 @@ Cache::states()
 
                 qDebug() << members.size() << "members for" << roomid;
 
-                state.memberships = members;
+                state.memberships = std::move(members);
+
+                // The member counts and the display names are rebuilt from
+                // the stored members.
+                for (auto it = state.memberships.constBegin(); it != state.memberships.constEnd();
+                     ++it) {
+                        state.summary.update(it.key(),
+                                             events::Membership::Leave,
+                                             it.value().content().membershipState());
+                        state.display_names.update(it.key(), it.value().content());
+                }
+
                 states.insert(roomid, state);
         }
 
@@ -211,6 +482,40 @@ Cache::states()
         return states;
 }
 
+QMap<QString, UnreadNotifications>
+Cache::unreadNotifications()
+{
+        QMap<QString, UnreadNotifications> counts;
+
+        auto txn    = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+        auto cursor = lmdb::cursor::open(txn, unreadDb_);
+
+        std::string room;
+        std::string data;
+
+        while (cursor.get(room, data, MDB_NEXT)) {
+                auto roomid = QString::fromUtf8(room.data(), room.size());
+                auto json   = QJsonDocument::fromBinaryData(QByteArray(data.data(), data.size()));
+
+                UnreadNotifications room_counts;
+
+                try {
+                        room_counts.deserialize(json.object());
+                } catch (const DeserializationException &e) {
+                        qWarning() << "Invalid unread counts for" << roomid << e.what();
+                        continue;
+                }
+
+                counts.insert(roomid, room_counts);
+        }
+
+        cursor.close();
+
+        txn.commit();
+
+        return counts;
+}
+
 void
 Cache::setNextBatchToken(lmdb::txn &txn, const QString &token)
 {
@@ -244,3 +549,122 @@ Cache::nextBatchToken() const
 
         return QString::fromUtf8(token.data(), token.size());
 }
+
+void
+Cache::setPendingReadMarker(const QString &roomid, const QString &event_id)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn   = lmdb::txn::begin(env_);
+        auto id    = roomid.toUtf8();
+        auto event = event_id.toUtf8();
+
+        lmdb::dbi_put(txn,
+                      readMarkersDb_,
+                      lmdb::val(id.data(), id.size()),
+                      lmdb::val(event.data(), event.size()));
+
+        txn.commit();
+}
+
+void
+Cache::removePendingReadMarker(const QString &roomid)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn = lmdb::txn::begin(env_);
+        auto id  = roomid.toUtf8();
+
+        lmdb::dbi_del(txn, readMarkersDb_, lmdb::val(id.data(), id.size()), nullptr);
+
+        txn.commit();
+}
+
+QMap<QString, QString>
+Cache::pendingReadMarkers()
+{
+        QMap<QString, QString> markers;
+
+        auto txn    = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+        auto cursor = lmdb::cursor::open(txn, readMarkersDb_);
+
+        std::string room;
+        std::string event;
+
+        while (cursor.get(room, event, MDB_NEXT))
+                markers.insert(QString::fromUtf8(room.data(), room.size()),
+                               QString::fromUtf8(event.data(), event.size()));
+
+        cursor.close();
+
+        txn.commit();
+
+        return markers;
+}
+
+void
+Cache::saveOutboundMessage(const OutboundMessage &msg)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn  = lmdb::txn::begin(env_);
+        auto key  = outboxKey(msg.txnId());
+        auto data = QJsonDocument(msg.serialize()).toBinaryData();
+
+        lmdb::dbi_put(txn,
+                      outboxDb_,
+                      lmdb::val(key.data(), key.size()),
+                      lmdb::val(data.data(), data.size()));
+
+        txn.commit();
+}
+
+void
+Cache::removeOutboundMessage(int txn_id)
+{
+        if (!isMounted_)
+                return;
+
+        auto txn = lmdb::txn::begin(env_);
+        auto key = outboxKey(txn_id);
+
+        lmdb::dbi_del(txn, outboxDb_, lmdb::val(key.data(), key.size()), nullptr);
+
+        txn.commit();
+}
+
+QList<OutboundMessage>
+Cache::outboundMessages()
+{
+        QList<OutboundMessage> messages;
+
+        auto txn    = lmdb::txn::begin(env_, nullptr, MDB_RDONLY);
+        auto cursor = lmdb::cursor::open(txn, outboxDb_);
+
+        std::string key;
+        std::string data;
+
+        while (cursor.get(key, data, MDB_NEXT)) {
+                auto json = QJsonDocument::fromBinaryData(QByteArray(data.data(), data.size()));
+
+                OutboundMessage msg;
+
+                try {
+                        msg.deserialize(json.object());
+                } catch (const DeserializationException &e) {
+                        qWarning() << "Skipping invalid outbound message" << e.what();
+                        continue;
+                }
+
+                messages.append(msg);
+        }
+
+        cursor.close();
+
+        txn.commit();
+
+        return messages;
+}
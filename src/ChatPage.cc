@@ -16,7 +16,12 @@
  */
 
 #include <QDebug>
+#include <QFutureWatcher>
+#include <QPair>
 #include <QSettings>
+#include <QtConcurrent>
+
+#include <utility>
 
 #include "AvatarProvider.h"
 #include "ChatPage.h"
@@ -31,6 +36,44 @@
 
 namespace events = matrix::events;
 
+using JoinedRoomEntry = QPair<QString, JoinedRoom>;
+using RoomStateEntry  = QPair<QString, RoomState>;
+
+// Build the state of a room from the initial sync. Rooms don't share any data
+// so this can run on any thread.
+static RoomStateEntry
+buildInitialRoomState(const JoinedRoomEntry &entry)
+{
+        RoomState room_state;
+
+        // Build the current state from the timeline and state events.
+        room_state.updateFromEvents(entry.second.state().events());
+        room_state.updateFromEvents(entry.second.timeline().events());
+        room_state.summary.updateFromServer(entry.second.summary());
+
+        // Remove redundant memberships.
+        room_state.removeLeaveMemberships();
+
+        // Resolve room name and avatar. e.g in case of one-to-one chats.
+        room_state.resolveName();
+        room_state.resolveAvatar();
+
+        return qMakePair(entry.first, room_state);
+}
+
+// Resolve user avatars.
+static void
+setMemberAvatarUrls(const RoomState &room_state)
+{
+        for (const auto &membership : room_state.memberships) {
+                auto uid = membership.senderHandle();
+                auto url = membership.content().avatarUrl();
+
+                if (!url.toString().isEmpty())
+                        AvatarProvider::setAvatarUrl(uid, url);
+        }
+}
+
 ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
   : QWidget(parent)
   , sync_interval_(2000)
@@ -92,15 +135,21 @@ ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
         splitter->addWidget(sideBar_);
         splitter->addWidget(content_);
 
-        room_list_ = new RoomList(client, sideBar_);
+        registry_ = QSharedPointer<RoomRegistry>(new RoomRegistry);
+
+        room_list_ = new RoomList(client, registry_, sideBar_);
         sideBarMainLayout_->addWidget(room_list_);
 
         top_bar_ = new TopRoomBar(this);
         topBarLayout_->addWidget(top_bar_);
 
-        view_manager_ = new TimelineViewManager(client, this);
+        outbox_ = QSharedPointer<Outbox>(new Outbox(client));
+
+        view_manager_ = new TimelineViewManager(client, registry_, outbox_, this);
         mainContentLayout_->addWidget(view_manager_);
 
+        read_markers_ = new ReadMarkerQueue(client, this);
+
         text_input_ = new TextInputWidget(this);
         contentLayout_->addWidget(text_input_);
 
@@ -119,18 +168,22 @@ ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
         connect(
           room_list_, &RoomList::roomChanged, view_manager_, &TimelineViewManager::setHistoryView);
 
-        connect(view_manager_,
-                &TimelineViewManager::unreadMessages,
+        connect(registry_.data(),
+                &RoomRegistry::nameChanged,
                 this,
-                [=](const QString &roomid, int count) {
-                        if (!settingsManager_.contains(roomid)) {
-                                qWarning() << "RoomId does not have settings" << roomid;
-                                room_list_->updateUnreadMessageCount(roomid, count);
-                                return;
-                        }
-
-                        if (settingsManager_[roomid]->isNotificationsEnabled())
-                                room_list_->updateUnreadMessageCount(roomid, count);
+                [=](RoomHandle room, const QString &name) {
+                        if (room == current_room_)
+                                top_bar_->updateRoomName(name);
+                });
+        connect(top_bar_, &TopRoomBar::notificationsToggled, this, [=]() {
+                registry_->notificationsToggled(current_room_);
+        });
+        connect(registry_.data(),
+                &RoomRegistry::topicChanged,
+                this,
+                [=](RoomHandle room, const QString &topic) {
+                        if (room == current_room_)
+                                top_bar_->updateRoomTopic(topic);
                 });
 
         connect(view_manager_,
@@ -138,10 +191,15 @@ ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
                 room_list_,
                 &RoomList::updateRoomDescription);
 
-        connect(room_list_,
-                SIGNAL(totalUnreadMessageCountUpdated(int)),
+        connect(view_manager_,
+                &TimelineViewManager::eventsRead,
+                read_markers_,
+                &ReadMarkerQueue::markRead);
+
+        connect(registry_.data(),
+                &RoomRegistry::totalNotificationCountChanged,
                 this,
-                SLOT(showUnreadMessageNotification(int)));
+                &ChatPage::showUnreadMessageNotification);
 
         connect(text_input_,
                 SIGNAL(sendTextMessage(const QString &)),
@@ -154,7 +212,7 @@ ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
                 SLOT(sendEmoteMessage(const QString &)));
 
         connect(text_input_, &TextInputWidget::uploadImage, this, [=](QString filename) {
-                client_->uploadImage(current_room_, filename);
+                client_->uploadImage(registry_->roomId(current_room_), filename);
         });
 
         connect(client_.data(),
@@ -165,6 +223,20 @@ ChatPage::ChatPage(QSharedPointer<MatrixClient> client, QWidget *parent)
                         view_manager_->sendImageMessage(roomid, filename, url);
                 });
 
+        // The pages of history are kept with the tail of the timeline, so the
+        // scrollback survives the view of the room.
+        connect(client_.data(),
+                &MatrixClient::messagesRetrieved,
+                this,
+                [=](const QString &room_id, const RoomMessages &msgs) {
+                        try {
+                                cache_->saveHistory(room_id, msgs);
+                        } catch (const lmdb::error &e) {
+                                qCritical() << "The history couldn't be cached:" << e.what();
+                                cache_->unmount();
+                        }
+                });
+
         connect(client_.data(),
                 SIGNAL(roomAvatarRetrieved(const QString &, const QPixmap &)),
                 this,
@@ -211,6 +283,8 @@ ChatPage::logout()
         settings.remove("");
         settings.endGroup();
 
+        read_markers_->clear();
+        outbox_->clear();
         cache_->deleteData();
 
         // Clear the environment.
@@ -221,9 +295,8 @@ ChatPage::logout()
         user_info_widget_->reset();
         client_->reset();
 
-        state_manager_.clear();
-        settingsManager_.clear();
-        room_avatars_.clear();
+        registry_->clear();
+        current_room_ = RoomRegistry::InvalidRoom;
 
         AvatarProvider::clear();
 
@@ -237,12 +310,19 @@ ChatPage::bootstrap(QString userid, QString homeserver, QString token)
         client_->setAccessToken(token);
         client_->getOwnProfile();
 
+        // The local user is never one of the heroes of a room.
+        RoomSummary::setLocalUser(matrix::Identifier(userid));
+
         try {
                 cache_ = QSharedPointer<Cache>(new Cache(userid));
         } catch (const std::exception &e) {
                 qCritical() << e.what();
         }
 
+        read_markers_->setCache(cache_);
+        outbox_->setCache(cache_);
+        view_manager_->setCache(cache_);
+
         if (cache_->isInitialized())
                 loadStateFromCache();
         else
@@ -268,50 +348,53 @@ ChatPage::syncFailed(const QString &msg)
         sync_timer_->start(sync_interval_ * 5);
 }
 
-// TODO: Should be moved in another class that manages this global list.
 void
-ChatPage::updateDisplayNames(const RoomState &state)
+ChatPage::syncCompleted(const SyncResponse &response)
 {
-        for (const auto member : state.memberships) {
-                auto displayName = member.content().displayName();
+        auto joined = response.rooms().join();
+        auto left   = response.rooms().leave();
+
+        // Leaves are applied first, so a room that was left and joined again
+        // within the same batch starts from a clean state.
+        for (auto it = left.constBegin(); it != left.constEnd(); it++) {
+                auto room = registry_->handle(it.key());
+
+                // e.g a rejected invite.
+                if (room == RoomRegistry::InvalidRoom)
+                        continue;
 
-                if (!displayName.isEmpty())
-                        TimelineViewManager::DISPLAY_NAMES.insert(member.stateKey(), displayName);
+                removeRoom(room);
         }
-}
 
-void
-ChatPage::syncCompleted(const SyncResponse &response)
-{
-        auto joined = response.rooms().join();
+        // Invites aren't shown yet. Accepting one elsewhere makes the room
+        // appear in the joined rooms of a following sync.
 
-        for (auto it = joined.constBegin(); it != joined.constEnd(); it++) {
-                RoomState room_state;
+        QVector<RoomHandle> updated;
+        updated.reserve(joined.size());
 
-                // Merge the new updates for rooms that we are tracking.
-                if (state_manager_.contains(it.key()))
-                        room_state = state_manager_[it.key()];
+        QMap<QString, Timeline> timelines;
 
-                room_state.updateFromEvents(it.value().state().events());
-                room_state.updateFromEvents(it.value().timeline().events());
+        for (auto it = joined.constBegin(); it != joined.constEnd(); it++) {
+                timelines.insert(it.key(), it.value().timeline());
 
-                updateDisplayNames(room_state);
+                // This is the only place where the room ID of a sync is resolved.
+                auto room = registry_->handle(it.key());
 
-                if (state_manager_.contains(it.key())) {
-                        // TODO: Use pointers instead of copying.
-                        auto oldState = state_manager_[it.key()];
-                        oldState.update(room_state);
-                        state_manager_.insert(it.key(), oldState);
-                } else {
-                        qWarning() << "New rooms cannot be added after initial sync, yet.";
+                if (room == RoomRegistry::InvalidRoom) {
+                        updated.append(addRoom(it.key(), it.value()));
+                        continue;
                 }
 
-                if (it.key() == current_room_)
-                        changeTopRoomInfo(it.key());
+                // The registry applies the updates in place and signals what changed.
+                registry_->update(room, it.value());
+                view_manager_->sync(room, it.value().timeline());
+
+                updated.append(room);
         }
 
         try {
-                cache_->setState(response.nextBatch(), state_manager_);
+                cache_->setState(response.nextBatch(), *registry_, updated);
+                cache_->saveTimelines(timelines);
         } catch (const lmdb::error &e) {
                 qCritical() << "The cache couldn't be updated: " << e.what();
                 // TODO: Notify the user.
@@ -320,72 +403,118 @@ ChatPage::syncCompleted(const SyncResponse &response)
 
         client_->setNextBatchToken(response.nextBatch());
 
-        room_list_->sync(state_manager_);
-        view_manager_->sync(response.rooms());
-
         sync_timer_->start(sync_interval_);
 }
 
+RoomHandle
+ChatPage::addRoom(const QString &room_id, const JoinedRoom &data)
+{
+        // A single room is cheap enough to be built on the GUI thread.
+        auto room_state = buildInitialRoomState(qMakePair(room_id, data)).second;
+
+        setMemberAvatarUrls(room_state);
+
+        auto room = registry_->insert(room_id, std::move(room_state));
+        registry_->setUnreadNotifications(room, data.unreadNotifications());
+
+        room_list_->addRoom(room);
+        view_manager_->addRoom(room, data.timeline());
+
+        return room;
+}
+
+void
+ChatPage::removeRoom(RoomHandle room)
+{
+        auto room_id = registry_->roomId(room);
+
+        if (current_room_ == room) {
+                current_room_ = RoomRegistry::InvalidRoom;
+                top_bar_->reset();
+        }
+
+        // The room list selects another room if the removed one was active.
+        view_manager_->removeRoom(room);
+        room_list_->removeRoom(room);
+
+        try {
+                cache_->removeRoom(room_id);
+        } catch (const lmdb::error &e) {
+                qCritical() << "The room couldn't be removed from the cache:" << e.what();
+                cache_->unmount();
+        }
+
+        registry_->remove(room);
+}
+
 void
 ChatPage::initialSyncCompleted(const SyncResponse &response)
 {
         auto joined = response.rooms().join();
 
-        for (auto it = joined.constBegin(); it != joined.constEnd(); it++) {
-                RoomState room_state;
+        QList<JoinedRoomEntry> entries;
+        entries.reserve(joined.size());
 
-                // Build the current state from the timeline and state events.
-                room_state.updateFromEvents(it.value().state().events());
-                room_state.updateFromEvents(it.value().timeline().events());
+        QMap<QString, Timeline> timelines;
 
-                // Remove redundant memberships.
-                room_state.removeLeaveMemberships();
+        for (auto it = joined.constBegin(); it != joined.constEnd(); it++) {
+                entries.append(qMakePair(it.key(), it.value()));
+                timelines.insert(it.key(), it.value().timeline());
+        }
 
-                // Resolve room name and avatar. e.g in case of one-to-one chats.
-                room_state.resolveName();
-                room_state.resolveAvatar();
+        using Watcher = QFutureWatcher<QPair<QString, RoomState>>;
+        auto watcher  = new Watcher(this);
 
-                updateDisplayNames(room_state);
+        connect(watcher, &Watcher::finished, this, [=]() {
+                watcher->deleteLater();
 
-                state_manager_.insert(it.key(), room_state);
-                settingsManager_.insert(it.key(),
-                                        QSharedPointer<RoomSettings>(new RoomSettings(it.key())));
+                // Only the merge into the shared maps happens on the GUI thread.
+                for (auto entry : watcher->future().results()) {
+                        const auto &room_id = entry.first;
+                        auto &room_state    = entry.second;
 
-                for (const auto membership : room_state.memberships) {
-                        auto uid = membership.sender();
-                        auto url = membership.content().avatarUrl();
+                        setMemberAvatarUrls(room_state);
 
-                        if (!url.toString().isEmpty())
-                                AvatarProvider::setAvatarUrl(uid, url);
+                        auto room = registry_->insert(room_id, std::move(room_state));
+                        registry_->setUnreadNotifications(
+                          room, joined.value(room_id).unreadNotifications());
                 }
-        }
 
-        try {
-                cache_->setState(response.nextBatch(), state_manager_);
-        } catch (const lmdb::error &e) {
-                qCritical() << "The cache couldn't be initialized: " << e.what();
-                cache_->unmount();
-        }
+                try {
+                        cache_->setState(response.nextBatch(), *registry_);
+                        cache_->saveTimelines(timelines);
+                } catch (const lmdb::error &e) {
+                        qCritical() << "The cache couldn't be initialized: " << e.what();
+                        cache_->unmount();
+                }
 
-        client_->setNextBatchToken(response.nextBatch());
+                client_->setNextBatchToken(response.nextBatch());
 
-        // Populate timelines with messages.
-        view_manager_->initialize(response.rooms());
+                // Initialize room list.
+                room_list_->setInitialRooms();
 
-        // Initialize room list.
-        room_list_->setInitialRooms(settingsManager_, state_manager_);
+                // Show the last message of every room. The timelines are created
+                // from the cache when their room is shown.
+                view_manager_->initialize(response.rooms());
 
-        sync_timer_->start(sync_interval_);
+                sync_timer_->start(sync_interval_);
 
-        emit contentLoaded();
+                emit contentLoaded();
+        });
+
+        // The rooms are processed in parallel on the global thread pool, while
+        // the GUI thread keeps handling events.
+        watcher->setFuture(QtConcurrent::mapped(entries, buildInitialRoomState));
 }
 
 void
 ChatPage::updateTopBarAvatar(const QString &roomid, const QPixmap &img)
 {
-        room_avatars_.insert(roomid, img);
+        auto room = registry_->handle(roomid);
+
+        registry_->setAvatar(room, img);
 
-        if (current_room_ != roomid)
+        if (room == RoomRegistry::InvalidRoom || room != current_room_)
                 return;
 
         top_bar_->updateRoomAvatar(img.toImage());
@@ -407,21 +536,22 @@ ChatPage::updateOwnProfileInfo(const QUrl &avatar_url, const QString &display_na
 void
 ChatPage::changeTopRoomInfo(const QString &room_id)
 {
-        if (!state_manager_.contains(room_id))
-                return;
+        auto room  = registry_->handle(room_id);
+        auto state = registry_->state(room);
 
-        auto state = state_manager_[room_id];
+        if (state.isNull())
+                return;
 
-        top_bar_->updateRoomName(state.getName());
-        top_bar_->updateRoomTopic(state.getTopic());
-        top_bar_->setRoomSettings(settingsManager_[room_id]);
+        top_bar_->updateRoomName(state->getName());
+        top_bar_->updateRoomTopic(state->getTopic());
+        top_bar_->setRoomSettings(registry_->settings(room));
 
-        if (room_avatars_.contains(room_id))
-                top_bar_->updateRoomAvatar(room_avatars_.value(room_id).toImage());
+        if (!registry_->avatar(room).isNull())
+                top_bar_->updateRoomAvatar(registry_->avatar(room).toImage());
         else
-                top_bar_->updateRoomAvatarFromName(state.getName());
+                top_bar_->updateRoomAvatarFromName(state->getName());
 
-        current_room_ = room_id;
+        current_room_ = room;
 }
 
 void
@@ -450,42 +580,30 @@ ChatPage::loadStateFromCache()
                 return;
         }
 
-        // Fetch all the joined room's state.
-        auto rooms = cache_->states();
+        // Fetch all the joined room's state and their unread counts.
+        auto rooms  = cache_->states();
+        auto unread = cache_->unreadNotifications();
 
-        for (auto it = rooms.constBegin(); it != rooms.constEnd(); it++) {
-                RoomState room_state = it.value();
+        for (auto it = rooms.begin(); it != rooms.end(); it++) {
+                auto &room_state = it.value();
 
                 // Clean up and prepare state for use.
                 room_state.removeLeaveMemberships();
                 room_state.resolveName();
                 room_state.resolveAvatar();
 
-                // Update the global list with user's display names.
-                updateDisplayNames(room_state);
-
-                // Save the current room state.
-                state_manager_.insert(it.key(), room_state);
+                setMemberAvatarUrls(room_state);
 
-                // Create or restore the settings for this room.
-                settingsManager_.insert(it.key(),
-                                        QSharedPointer<RoomSettings>(new RoomSettings(it.key())));
-
-                // Resolve user avatars.
-                for (const auto membership : room_state.memberships) {
-                        auto uid = membership.sender();
-                        auto url = membership.content().avatarUrl();
-
-                        if (!url.toString().isEmpty())
-                                AvatarProvider::setAvatarUrl(uid, url);
-                }
+                // Save the current room state. The settings of the room are restored too.
+                auto room = registry_->insert(it.key(), std::move(room_state));
+                registry_->setUnreadNotifications(room, unread.value(it.key()));
         }
 
-        // Initializing empty timelines.
-        view_manager_->initialize(rooms.keys());
-
         // Initialize room list from the restored state and settings.
-        room_list_->setInitialRooms(settingsManager_, state_manager_);
+        room_list_->setInitialRooms();
+
+        // Show the last message of every room from the cached timelines.
+        view_manager_->initialize(rooms.keys());
 
         // Remove the spinner overlay.
         emit contentLoaded();
@@ -526,8 +644,10 @@ ChatPage::showQuickSwitcher()
 
         QMap<QString, QString> rooms;
 
-        for (auto it = state_manager_.constBegin(); it != state_manager_.constEnd(); ++it)
-                rooms.insert(it.value().getName(), it.key());
+        for (RoomHandle room = 0; room < registry_->size(); ++room) {
+                if (registry_->contains(room))
+                        rooms.insert(registry_->state(room)->getName(), registry_->roomId(room));
+        }
 
         quickSwitcher_->setRoomList(rooms);
         quickSwitcherModal_->fadeIn();
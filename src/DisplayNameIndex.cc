@@ -0,0 +1,109 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DisplayNameIndex.h"
+
+void
+DisplayNameIndex::update(const matrix::Identifier &user_id,
+                         const events::MemberEventContent &member)
+{
+        switch (member.membershipState()) {
+        case events::Membership::Invite:
+        case events::Membership::Join:
+                insert(user_id, member.displayName());
+                break;
+        case events::Membership::Ban:
+        case events::Membership::Knock:
+        case events::Membership::Leave:
+                remove(user_id);
+                break;
+        }
+}
+
+void
+DisplayNameIndex::insert(const matrix::Identifier &user_id, const QString &name)
+{
+        auto it = names_.find(user_id);
+
+        if (it != names_.end()) {
+                if (it.value() == name)
+                        return;
+
+                remove(user_id);
+        }
+
+        names_.insert(user_id, name);
+
+        if (!name.isEmpty())
+                occurrences_[name] += 1;
+}
+
+void
+DisplayNameIndex::remove(const matrix::Identifier &user_id)
+{
+        auto it = names_.find(user_id);
+
+        if (it == names_.end())
+                return;
+
+        const auto name = it.value();
+        names_.erase(it);
+
+        if (name.isEmpty())
+                return;
+
+        auto count = occurrences_.find(name);
+
+        if (count == occurrences_.end())
+                return;
+
+        if (--count.value() <= 0)
+                occurrences_.erase(count);
+}
+
+void
+DisplayNameIndex::clear()
+{
+        names_.clear();
+        occurrences_.clear();
+}
+
+QString
+DisplayNameIndex::displayName(const matrix::Identifier &user_id) const
+{
+        auto it = names_.constFind(user_id);
+
+        if (it == names_.constEnd() || it.value().isEmpty())
+                return user_id.toString();
+
+        if (occurrences_.value(it.value()) > 1)
+                return QString("%1 (%2)").arg(it.value()).arg(user_id.toString());
+
+        return it.value();
+}
+
+QString
+DisplayNameIndex::displayName(const QString &user_id) const
+{
+        // Users we've never seen can't have a display name, so don't intern them.
+        auto id = matrix::Identifier::find(user_id);
+
+        if (id.isEmpty())
+                return user_id;
+
+        return displayName(id);
+}
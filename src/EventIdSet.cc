@@ -0,0 +1,126 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+
+#include "EventIdSet.h"
+
+const int EventIdSet::DefaultCapacity = 8192;
+
+// The value of the empty slots. No ID hashes to it.
+static const quint64 EMPTY_SLOT = 0;
+
+EventIdSet::EventIdSet(int capacity)
+  : capacity_{ std::max(capacity, 2) }
+{
+        // Each table holds half of the capacity and is at most half full.
+        int slots = 2;
+        while (slots < capacity_)
+                slots *= 2;
+
+        mask_ = slots - 1;
+
+        newer_.slots.fill(EMPTY_SLOT, slots);
+        older_.slots.fill(EMPTY_SLOT, slots);
+}
+
+quint64
+EventIdSet::hash(const QString &event_id)
+{
+        // FNV-1a over the UTF-16 code units.
+        quint64 h = 14695981039346656037ULL;
+
+        for (const auto &c : event_id) {
+                h ^= c.unicode();
+                h *= 1099511628211ULL;
+        }
+
+        // Spread the bits, since the slot is taken from the lowest ones.
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+
+        return h == EMPTY_SLOT ? 1 : h;
+}
+
+bool
+EventIdSet::contains(const Table &table, quint64 key)
+{
+        if (table.size == 0)
+                return false;
+
+        const int mask = table.slots.size() - 1;
+
+        for (int i = key & mask;; i = (i + 1) & mask) {
+                const quint64 slot = table.slots.at(i);
+
+                if (slot == key)
+                        return true;
+
+                if (slot == EMPTY_SLOT)
+                        return false;
+        }
+}
+
+bool
+EventIdSet::contains(const QString &event_id) const
+{
+        const quint64 key = hash(event_id);
+
+        return contains(newer_, key) || contains(older_, key);
+}
+
+bool
+EventIdSet::insert(const QString &event_id)
+{
+        const quint64 key = hash(event_id);
+
+        if (contains(newer_, key) || contains(older_, key))
+                return false;
+
+        if (newer_.size >= capacity_ / 2) {
+                std::swap(newer_, older_);
+
+                newer_.slots.fill(EMPTY_SLOT);
+                newer_.size = 0;
+        }
+
+        int i = key & mask_;
+        while (newer_.slots.at(i) != EMPTY_SLOT)
+                i = (i + 1) & mask_;
+
+        newer_.slots[i] = key;
+        newer_.size += 1;
+
+        return true;
+}
+
+void
+EventIdSet::clear()
+{
+        newer_.slots.fill(EMPTY_SLOT);
+        older_.slots.fill(EMPTY_SLOT);
+
+        newer_.size = 0;
+        older_.size = 0;
+}
+
+int
+EventIdSet::size() const
+{
+        return newer_.size + older_.size;
+}
@@ -0,0 +1,114 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QReadLocker>
+#include <QReadWriteLock>
+#include <QVector>
+#include <QWriteLocker>
+
+#include "Identifier.h"
+
+using namespace matrix;
+
+namespace
+{
+struct InternTable {
+        QReadWriteLock lock;
+
+        // Maps every interned string to its handle.
+        QHash<QString, quint32> handles;
+
+        // Indexed by handle. Slot 0 is reserved for the empty string.
+        QVector<QString> strings{ QString() };
+};
+
+InternTable &
+table()
+{
+        static InternTable instance;
+        return instance;
+}
+} // namespace
+
+Identifier::Identifier(const QString &id)
+{
+        if (id.isEmpty())
+                return;
+
+        auto &t = table();
+
+        {
+                QReadLocker locker(&t.lock);
+
+                auto it = t.handles.constFind(id);
+                if (it != t.handles.constEnd()) {
+                        handle_ = it.value();
+                        return;
+                }
+        }
+
+        QWriteLocker locker(&t.lock);
+
+        // Another thread might have interned the same string in the meantime.
+        auto it = t.handles.constFind(id);
+        if (it != t.handles.constEnd()) {
+                handle_ = it.value();
+                return;
+        }
+
+        handle_ = static_cast<quint32>(t.strings.size());
+
+        t.strings.append(id);
+        t.handles.insert(id, handle_);
+}
+
+Identifier
+Identifier::find(const QString &id)
+{
+        Identifier result;
+
+        if (id.isEmpty())
+                return result;
+
+        auto &t = table();
+        QReadLocker locker(&t.lock);
+
+        result.handle_ = t.handles.value(id, 0);
+
+        return result;
+}
+
+int
+Identifier::count()
+{
+        auto &t = table();
+        QReadLocker locker(&t.lock);
+
+        return t.strings.size() - 1;
+}
+
+QString
+Identifier::toString() const
+{
+        if (handle_ == 0)
+                return QString();
+
+        auto &t = table();
+        QReadLocker locker(&t.lock);
+
+        return t.strings.at(handle_);
+}
@@ -307,22 +307,22 @@ MatrixClient::onSendRoomMessage(QNetworkReply *reply)
 {
         reply->deleteLater();
 
-        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        int status  = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+        auto roomid = reply->property("roomid").toString();
+        auto txn_id = reply->property("txn_id").toInt();
 
         if (status == 0 || status >= 400) {
                 qWarning() << reply->errorString();
+                emit messageSendFailed(roomid, txn_id, status);
                 return;
         }
 
         auto data = reply->readAll();
-
-        if (data.isEmpty())
-                return;
-
         auto json = QJsonDocument::fromJson(data);
 
         if (!json.isObject()) {
                 qDebug() << "Send message response is not a JSON object";
+                emit messageSendFailed(roomid, txn_id, status);
                 return;
         }
 
@@ -330,12 +330,11 @@ MatrixClient::onSendRoomMessage(QNetworkReply *reply)
 
         if (!object.contains("event_id")) {
                 qDebug() << "SendTextMessage: missing event_id from response";
+                emit messageSendFailed(roomid, txn_id, status);
                 return;
         }
 
-        emit messageSent(object.value("event_id").toString(),
-                         reply->property("roomid").toString(),
-                         reply->property("txn_id").toInt());
+        emit messageSent(object.value("event_id").toString(), roomid, txn_id);
 }
 
 void
@@ -442,13 +441,16 @@ MatrixClient::onMessagesResponse(QNetworkReply *reply)
 
         int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
 
+        auto room_id    = reply->property("room_id").toString();
+        auto from_token = reply->property("from").toString();
+
         if (status == 0 || status >= 400) {
                 qWarning() << reply->errorString();
+                emit messagesFailed(room_id, from_token);
                 return;
         }
 
-        auto data    = reply->readAll();
-        auto room_id = reply->property("room_id").toString();
+        auto data = reply->readAll();
 
         RoomMessages msgs;
 
@@ -456,12 +458,31 @@ MatrixClient::onMessagesResponse(QNetworkReply *reply)
                 msgs.deserialize(QJsonDocument::fromJson(data));
         } catch (const DeserializationException &e) {
                 qWarning() << "Room messages from" << room_id << e.what();
+                emit messagesFailed(room_id, from_token);
                 return;
         }
 
         emit messagesRetrieved(room_id, msgs);
 }
 
+void
+MatrixClient::onReadMarkersResponse(QNetworkReply *reply)
+{
+        reply->deleteLater();
+
+        int status = reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt();
+
+        if (status == 0 || status >= 400) {
+                qWarning() << "Read markers:" << reply->errorString();
+                emit readMarkersFailed(reply->property("room_id").toString(),
+                                       reply->property("event_id").toString());
+                return;
+        }
+
+        emit readMarkersSent(reply->property("room_id").toString(),
+                             reply->property("event_id").toString());
+}
+
 void
 MatrixClient::onResponse(QNetworkReply *reply)
 {
@@ -508,6 +529,9 @@ MatrixClient::onResponse(QNetworkReply *reply)
         case Endpoint::Messages:
                 onMessagesResponse(reply);
                 break;
+        case Endpoint::ReadMarkers:
+                onReadMarkersResponse(reply);
+                break;
         default:
                 break;
         }
@@ -599,46 +623,25 @@ MatrixClient::sync() noexcept
 }
 
 void
-MatrixClient::sendRoomMessage(matrix::events::MessageEventType ty,
-                              const QString &roomid,
-                              const QString &msg,
-                              const QString &url) noexcept
+MatrixClient::sendRoomMessage(const QString &roomid,
+                              int txn_id,
+                              const QJsonObject &content) noexcept
 {
         QUrlQuery query;
         query.addQueryItem("access_token", token_);
 
         QUrl endpoint(server_);
         endpoint.setPath(clientApiUrl_ +
-                         QString("/rooms/%1/send/m.room.message/%2").arg(roomid).arg(txn_id_));
+                         QString("/rooms/%1/send/m.room.message/%2").arg(roomid).arg(txn_id));
         endpoint.setQuery(query);
 
-        QString msgType("");
-        QJsonObject body;
-
-        switch (ty) {
-        case matrix::events::MessageEventType::Text:
-                body = { { "msgtype", "m.text" }, { "body", msg } };
-                break;
-        case matrix::events::MessageEventType::Emote:
-                body = { { "msgtype", "m.emote" }, { "body", msg } };
-                break;
-        case matrix::events::MessageEventType::Image:
-                body = { { "msgtype", "m.image" }, { "body", msg }, { "url", url } };
-                break;
-        default:
-                qDebug() << "SendRoomMessage: Unknown message type for" << msg;
-                return;
-        }
-
         QNetworkRequest request(QString(endpoint.toEncoded()));
         request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
 
-        QNetworkReply *reply = put(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        QNetworkReply *reply = put(request, QJsonDocument(content).toJson(QJsonDocument::Compact));
         reply->setProperty("endpoint", static_cast<int>(Endpoint::SendRoomMessage));
-        reply->setProperty("txn_id", txn_id_);
+        reply->setProperty("txn_id", txn_id);
         reply->setProperty("roomid", roomid);
-
-        incrementTransactionId();
 }
 
 void
@@ -813,6 +816,7 @@ MatrixClient::messages(const QString &room_id, const QString &from_token, int li
         QNetworkReply *reply = get(request);
         reply->setProperty("endpoint", static_cast<int>(Endpoint::Messages));
         reply->setProperty("room_id", room_id);
+        reply->setProperty("from", from_token);
 }
 
 void
@@ -842,3 +846,24 @@ MatrixClient::uploadImage(const QString &roomid, const QString &filename)
         reply->setProperty("room_id", roomid);
         reply->setProperty("filename", filename);
 }
+
+void
+MatrixClient::readMarkers(const QString &room_id, const QString &event_id) noexcept
+{
+        QUrlQuery query;
+        query.addQueryItem("access_token", token_);
+
+        QUrl endpoint(server_);
+        endpoint.setPath(clientApiUrl_ + QString("/rooms/%1/read_markers").arg(room_id));
+        endpoint.setQuery(query);
+
+        QJsonObject body{ { "m.fully_read", event_id }, { "m.read", event_id } };
+
+        QNetworkRequest request(QString(endpoint.toEncoded()));
+        request.setHeader(QNetworkRequest::ContentTypeHeader, "application/json");
+
+        QNetworkReply *reply = post(request, QJsonDocument(body).toJson(QJsonDocument::Compact));
+        reply->setProperty("endpoint", static_cast<int>(Endpoint::ReadMarkers));
+        reply->setProperty("room_id", room_id);
+        reply->setProperty("event_id", event_id);
+}
@@ -0,0 +1,75 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include "OutboundMessage.h"
+
+namespace events = matrix::events;
+
+OutboundMessage::OutboundMessage(const QString &room_id,
+                                 int txn_id,
+                                 events::MessageEventType ty,
+                                 const QString &body,
+                                 const QString &url)
+  : room_id_{ room_id }
+  , txn_id_{ txn_id }
+{
+        switch (ty) {
+        case events::MessageEventType::Text:
+                content_ = { { "msgtype", "m.text" }, { "body", body } };
+                break;
+        case events::MessageEventType::Emote:
+                content_ = { { "msgtype", "m.emote" }, { "body", body } };
+                break;
+        case events::MessageEventType::Image:
+                content_ = { { "msgtype", "m.image" }, { "body", body }, { "url", url } };
+                break;
+        default:
+                qWarning() << "OutboundMessage: Unknown message type for" << body;
+                break;
+        }
+}
+
+QJsonObject
+OutboundMessage::serialize() const
+{
+        QJsonObject object;
+
+        object["room_id"] = room_id_;
+        object["txn_id"]  = txn_id_;
+        object["content"] = content_;
+
+        return object;
+}
+
+void
+OutboundMessage::deserialize(const QJsonObject &object)
+{
+        if (!object.value("room_id").isString())
+                throw DeserializationException("outbound/room_id is missing");
+
+        if (!object.value("txn_id").isDouble())
+                throw DeserializationException("outbound/txn_id is missing");
+
+        if (!object.value("content").isObject())
+                throw DeserializationException("outbound/content is missing");
+
+        room_id_ = object.value("room_id").toString();
+        txn_id_  = object.value("txn_id").toInt();
+        content_ = object.value("content").toObject();
+}
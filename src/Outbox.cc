@@ -0,0 +1,216 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+#include <QSettings>
+#include <QTimer>
+
+#include <algorithm>
+
+#include "Outbox.h"
+
+const int Outbox::MinRetryDelay;
+const int Outbox::MaxRetryDelay;
+
+Outbox::Outbox(QSharedPointer<MatrixClient> client, QObject *parent)
+  : QObject(parent)
+  , client_(client)
+{
+        connect(client_.data(), &MatrixClient::messageSent, this, &Outbox::messageSent);
+        connect(
+          client_.data(), &MatrixClient::messageSendFailed, this, &Outbox::messageSendFailed);
+}
+
+void
+Outbox::setCache(QSharedPointer<Cache> cache)
+{
+        cache_ = cache;
+
+        if (cache_.isNull())
+                return;
+
+        QList<OutboundMessage> messages;
+
+        try {
+                messages = cache_->outboundMessages();
+        } catch (const lmdb::error &e) {
+                qWarning() << "Failed to restore the outbox" << e.what();
+                return;
+        }
+
+        // The cache returns them in the order of their transaction IDs.
+        for (const auto &msg : messages)
+                queues_[msg.roomId()].append(msg);
+
+        for (auto it = queues_.constBegin(); it != queues_.constEnd(); ++it)
+                dispatch(it.key());
+}
+
+void
+Outbox::clear()
+{
+        queues_.clear();
+        in_flight_.clear();
+        paused_.clear();
+        retry_delay_.clear();
+        cache_.clear();
+}
+
+int
+Outbox::enqueue(const QString &room_id,
+                matrix::events::MessageEventType ty,
+                const QString &body,
+                const QString &url)
+{
+        const int txn_id = client_->transactionId();
+
+        OutboundMessage msg(room_id, txn_id, ty, body, url);
+
+        if (msg.content().isEmpty())
+                return txn_id;
+
+        // Saved before the request is made, so the ID is never reused.
+        client_->incrementTransactionId();
+
+        QSettings settings;
+        settings.setValue("client/transaction_id", client_->transactionId());
+
+        if (!cache_.isNull()) {
+                try {
+                        cache_->saveOutboundMessage(msg);
+                } catch (const lmdb::error &e) {
+                        qWarning() << "Failed to store the outbound message" << txn_id << e.what();
+                }
+        }
+
+        queues_[room_id].append(msg);
+        dispatch(room_id);
+
+        return txn_id;
+}
+
+QList<OutboundMessage>
+Outbox::messages(const QString &room_id) const
+{
+        return queues_.value(room_id);
+}
+
+void
+Outbox::confirm(const QString &room_id, int txn_id)
+{
+        // The reply of a request that is in flight is ignored.
+        remove(room_id, txn_id);
+        dispatch(room_id);
+}
+
+void
+Outbox::dispatch(const QString &room_id)
+{
+        if (paused_.contains(room_id) || in_flight_.contains(room_id))
+                return;
+
+        const auto queue = queues_.value(room_id);
+
+        if (queue.isEmpty())
+                return;
+
+        const auto &msg = queue.first();
+
+        in_flight_.insert(room_id, msg.txnId());
+        client_->sendRoomMessage(room_id, msg.txnId(), msg.content());
+}
+
+bool
+Outbox::isInFlight(const QString &room_id, int txn_id) const
+{
+        return in_flight_.contains(room_id) && in_flight_.value(room_id) == txn_id;
+}
+
+void
+Outbox::remove(const QString &room_id, int txn_id)
+{
+        auto &queue = queues_[room_id];
+
+        auto it = std::find_if(queue.begin(), queue.end(), [txn_id](const OutboundMessage &msg) {
+                return msg.txnId() == txn_id;
+        });
+
+        if (it != queue.end())
+                queue.erase(it);
+
+        if (isInFlight(room_id, txn_id))
+                in_flight_.remove(room_id);
+
+        if (queue.isEmpty())
+                queues_.remove(room_id);
+
+        if (cache_.isNull())
+                return;
+
+        try {
+                cache_->removeOutboundMessage(txn_id);
+        } catch (const lmdb::error &e) {
+                qWarning() << "Failed to remove the outbound message" << txn_id << e.what();
+        }
+}
+
+void
+Outbox::messageSent(const QString &event_id, const QString &room_id, int txn_id)
+{
+        Q_UNUSED(event_id);
+
+        if (!isInFlight(room_id, txn_id))
+                return;
+
+        retry_delay_.remove(room_id);
+
+        remove(room_id, txn_id);
+        dispatch(room_id);
+}
+
+void
+Outbox::messageSendFailed(const QString &room_id, int txn_id, int status)
+{
+        if (!isInFlight(room_id, txn_id))
+                return;
+
+        // Client errors won't go away by retrying. Rate limiting is the exception.
+        if (status >= 400 && status < 500 && status != 429) {
+                qWarning() << "The message" << txn_id << "was rejected with status" << status;
+
+                remove(room_id, txn_id);
+                dispatch(room_id);
+
+                emit messageFailed(room_id, txn_id);
+                return;
+        }
+
+        in_flight_.remove(room_id);
+
+        if (paused_.contains(room_id))
+                return;
+
+        const int delay = retry_delay_.value(room_id, MinRetryDelay);
+        retry_delay_.insert(room_id, std::min(delay * 2, MaxRetryDelay));
+
+        paused_.insert(room_id);
+
+        QTimer::singleShot(delay, this, [=]() {
+                paused_.remove(room_id);
+                dispatch(room_id);
+        });
+}
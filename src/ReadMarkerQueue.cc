@@ -0,0 +1,137 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include "ReadMarkerQueue.h"
+
+ReadMarkerQueue::ReadMarkerQueue(QSharedPointer<MatrixClient> client, QObject *parent)
+  : QObject(parent)
+  , client_(client)
+{
+        timer_ = new QTimer(this);
+        timer_->setSingleShot(true);
+        timer_->setInterval(FlushInterval);
+
+        connect(timer_, &QTimer::timeout, this, &ReadMarkerQueue::flush);
+        connect(
+          client_.data(), &MatrixClient::readMarkersSent, this, &ReadMarkerQueue::markerSent);
+        connect(client_.data(),
+                &MatrixClient::readMarkersFailed,
+                this,
+                &ReadMarkerQueue::markerFailed);
+}
+
+void
+ReadMarkerQueue::setCache(QSharedPointer<Cache> cache)
+{
+        cache_ = cache;
+
+        if (cache_.isNull())
+                return;
+
+        try {
+                auto markers = cache_->pendingReadMarkers();
+
+                for (auto it = markers.constBegin(); it != markers.constEnd(); ++it)
+                        pending_.insert(it.key(), it.value());
+        } catch (const lmdb::error &e) {
+                qWarning() << "Failed to restore the pending read markers" << e.what();
+        }
+
+        if (!pending_.isEmpty() && !timer_->isActive())
+                timer_->start();
+}
+
+void
+ReadMarkerQueue::clear()
+{
+        timer_->stop();
+
+        pending_.clear();
+        sent_.clear();
+        cache_.clear();
+}
+
+void
+ReadMarkerQueue::markRead(const QString &room_id, const QString &event_id)
+{
+        if (room_id.isEmpty() || event_id.isEmpty())
+                return;
+
+        if (pending_.value(room_id) == event_id)
+                return;
+
+        if (!pending_.contains(room_id) && sent_.value(room_id) == event_id)
+                return;
+
+        pending_.insert(room_id, event_id);
+
+        if (!cache_.isNull()) {
+                try {
+                        cache_->setPendingReadMarker(room_id, event_id);
+                } catch (const lmdb::error &e) {
+                        qWarning() << "Failed to store the read marker of" << room_id << e.what();
+                }
+        }
+
+        if (!timer_->isActive())
+                timer_->start();
+}
+
+void
+ReadMarkerQueue::flush()
+{
+        for (auto it = pending_.constBegin(); it != pending_.constEnd(); ++it) {
+                client_->readMarkers(it.key(), it.value());
+                sent_.insert(it.key(), it.value());
+        }
+
+        pending_.clear();
+}
+
+void
+ReadMarkerQueue::markerSent(const QString &room_id, const QString &event_id)
+{
+        // A newer marker was queued in the meantime and replaced the stored one.
+        if (pending_.contains(room_id) || sent_.value(room_id) != event_id)
+                return;
+
+        if (cache_.isNull())
+                return;
+
+        try {
+                cache_->removePendingReadMarker(room_id);
+        } catch (const lmdb::error &e) {
+                qWarning() << "Failed to remove the read marker of" << room_id << e.what();
+        }
+}
+
+void
+ReadMarkerQueue::markerFailed(const QString &room_id, const QString &event_id)
+{
+        // A newer marker is already queued and replaces it.
+        if (pending_.contains(room_id) || sent_.value(room_id) != event_id)
+                return;
+
+        // It's still in the cache, so it only has to be queued again.
+        sent_.remove(room_id);
+        pending_.insert(room_id, event_id);
+
+        if (!timer_->isActive())
+                timer_->start();
+}
@@ -26,7 +26,7 @@
 #include "Theme.h"
 
 RoomInfoListItem::RoomInfoListItem(QSharedPointer<RoomSettings> settings,
-                                   RoomState state,
+                                   QSharedPointer<RoomState> state,
                                    QString room_id,
                                    QWidget *parent)
   : QWidget(parent)
@@ -56,6 +56,7 @@ RoomInfoListItem::RoomInfoListItem(QSharedPointer<RoomSettings> settings,
 
         connect(toggleNotifications_, &QAction::triggered, this, [=]() {
                 roomSettings_->toggleNotifications();
+                emit notificationsToggled(roomId_);
         });
 
         menu_->addAction(toggleNotifications_);
@@ -123,7 +124,7 @@ RoomInfoListItem::paintEvent(QPaintEvent *event)
                 int top_y = 2 * Padding + fontNameMetrics.ascent() / 2;
 
                 auto name = metrics.elidedText(
-                  state_.getName(), Qt::ElideRight, (width() - IconSize - 2 * Padding) * 0.8);
+                  state_->getName(), Qt::ElideRight, (width() - IconSize - 2 * Padding) * 0.8);
                 p.drawText(QPoint(2 * Padding + IconSize, top_y), name);
 
                 if (!isPressed_) {
@@ -187,7 +188,7 @@ RoomInfoListItem::paintEvent(QPaintEvent *event)
                 p.setPen(QColor("#333"));
                 p.setBrush(Qt::NoBrush);
                 p.drawText(
-                  avatarRegion.translated(0, -1), Qt::AlignCenter, QChar(state_.getName()[0]));
+                  avatarRegion.translated(0, -1), Qt::AlignCenter, QChar(state_->getName()[0]));
         } else {
                 p.save();
 
@@ -242,16 +243,9 @@ RoomInfoListItem::paintEvent(QPaintEvent *event)
 }
 
 void
-RoomInfoListItem::updateUnreadMessageCount(int count)
+RoomInfoListItem::setUnreadMessageCount(int count)
 {
-        unreadMsgCount_ += count;
-        update();
-}
-
-void
-RoomInfoListItem::clearUnreadMessageCount()
-{
-        unreadMsgCount_ = 0;
+        unreadMsgCount_ = count;
         update();
 }
 
@@ -267,13 +261,6 @@ RoomInfoListItem::setPressedState(bool state)
         }
 }
 
-void
-RoomInfoListItem::setState(const RoomState &new_state)
-{
-        state_ = new_state;
-        update();
-}
-
 void
 RoomInfoListItem::contextMenuEvent(QContextMenuEvent *event)
 {
@@ -23,9 +23,12 @@
 #include "RoomList.h"
 #include "Sync.h"
 
-RoomList::RoomList(QSharedPointer<MatrixClient> client, QWidget *parent)
+RoomList::RoomList(QSharedPointer<MatrixClient> client,
+                   QSharedPointer<RoomRegistry> registry,
+                   QWidget *parent)
   : QWidget(parent)
   , client_(client)
+  , registry_(registry)
 {
         setStyleSheet("QWidget { border: none; }");
 
@@ -59,6 +62,14 @@ RoomList::RoomList(QSharedPointer<MatrixClient> client, QWidget *parent)
                 SIGNAL(roomAvatarRetrieved(const QString &, const QPixmap &)),
                 this,
                 SLOT(updateRoomAvatar(const QString &, const QPixmap &)));
+
+        connect(registry_.data(), &RoomRegistry::nameChanged, this, &RoomList::updateRoomName);
+        connect(
+          registry_.data(), &RoomRegistry::avatarChanged, this, &RoomList::updateRoomAvatarUrl);
+        connect(registry_.data(),
+                &RoomRegistry::unreadNotificationsChanged,
+                this,
+                &RoomList::updateUnreadNotifications);
 }
 
 RoomList::~RoomList()
@@ -71,90 +82,102 @@ RoomList::clear()
         rooms_.clear();
 }
 
+QSharedPointer<RoomInfoListItem>
+RoomList::item(RoomHandle room) const
+{
+        return rooms_.value(room);
+}
+
 void
-RoomList::updateUnreadMessageCount(const QString &roomid, int count)
+RoomList::updateUnreadNotifications(RoomHandle room, const UnreadNotifications &counts)
 {
-        if (!rooms_.contains(roomid)) {
-                qWarning() << "UpdateUnreadMessageCount: Unknown roomid";
+        if (item(room).isNull())
                 return;
-        }
 
-        rooms_[roomid]->updateUnreadMessageCount(count);
-
-        calculateUnreadMessageCount();
+        // The muted rooms don't show a badge.
+        if (registry_->settings(room)->isNotificationsEnabled())
+                item(room)->setUnreadMessageCount(counts.notificationCount());
+        else
+                item(room)->setUnreadMessageCount(0);
 }
 
 void
-RoomList::calculateUnreadMessageCount()
+RoomList::setInitialRooms()
 {
-        int total_unread_msgs = 0;
+        rooms_.clear();
+        rooms_.resize(registry_->size());
 
-        for (const auto &room : rooms_)
-                total_unread_msgs += room->unreadMessageCount();
+        for (RoomHandle room = 0; room < registry_->size(); ++room) {
+                if (registry_->contains(room))
+                        createItem(room);
+        }
 
-        emit totalUnreadMessageCountUpdated(total_unread_msgs);
+        for (RoomHandle room = 0; room < rooms_.size(); ++room) {
+                if (!rooms_[room].isNull()) {
+                        highlightSelectedRoom(registry_->roomId(room));
+                        break;
+                }
+        }
 }
 
 void
-RoomList::setInitialRooms(const QMap<QString, QSharedPointer<RoomSettings>> &settings,
-                          const QMap<QString, RoomState> &states)
+RoomList::addRoom(RoomHandle room)
 {
-        rooms_.clear();
-
-        if (settings.size() != states.size()) {
-                qWarning() << "Initializing room list";
-                qWarning() << "Different number of room states and room settings";
+        if (!registry_->contains(room) || !item(room).isNull())
                 return;
-        }
 
-        for (auto it = states.constBegin(); it != states.constEnd(); it++) {
-                auto room_id = it.key();
-                auto state   = it.value();
+        if (rooms_.size() <= room)
+                rooms_.resize(room + 1);
+
+        createItem(room);
+}
 
-                if (!state.getAvatar().toString().isEmpty())
-                        client_->fetchRoomAvatar(room_id, state.getAvatar());
+void
+RoomList::removeRoom(RoomHandle room)
+{
+        auto removed = item(room);
 
-                RoomInfoListItem *room_item =
-                  new RoomInfoListItem(settings[room_id], state, room_id, scrollArea_);
-                connect(
-                  room_item, &RoomInfoListItem::clicked, this, &RoomList::highlightSelectedRoom);
+        if (removed.isNull())
+                return;
 
-                rooms_.insert(room_id, QSharedPointer<RoomInfoListItem>(room_item));
+        const bool was_selected = removed->isPressed();
 
-                int pos = contentsLayout_->count() - 1;
-                contentsLayout_->insertWidget(pos, room_item);
-        }
+        contentsLayout_->removeWidget(removed.data());
+        rooms_[room].reset();
 
-        if (rooms_.isEmpty())
+        if (!was_selected)
                 return;
 
-        auto first_room = rooms_.first();
-        first_room->setPressedState(true);
-
-        emit roomChanged(rooms_.firstKey());
+        for (RoomHandle other = 0; other < rooms_.size(); ++other) {
+                if (!rooms_[other].isNull()) {
+                        highlightSelectedRoom(registry_->roomId(other));
+                        return;
+                }
+        }
 }
 
 void
-RoomList::sync(const QMap<QString, RoomState> &states)
+RoomList::createItem(RoomHandle room)
 {
-        for (auto it = states.constBegin(); it != states.constEnd(); it++) {
-                auto room_id = it.key();
-                auto state   = it.value();
+        auto room_id = registry_->roomId(room);
+        auto state   = registry_->state(room);
 
-                // TODO: Add the new room to the list.
-                if (!rooms_.contains(room_id))
-                        continue;
+        if (!state->getAvatar().toString().isEmpty())
+                client_->fetchRoomAvatar(room_id, state->getAvatar());
 
-                auto room = rooms_[room_id];
+        RoomInfoListItem *room_item =
+          new RoomInfoListItem(registry_->settings(room), state, room_id, scrollArea_);
+        connect(room_item, &RoomInfoListItem::clicked, this, &RoomList::highlightSelectedRoom);
+        connect(room_item, &RoomInfoListItem::notificationsToggled, this, [=](const QString &id) {
+                registry_->notificationsToggled(registry_->handle(id));
+        });
 
-                auto current_avatar = room->state().getAvatar();
-                auto new_avatar     = state.getAvatar();
+        rooms_[room] = QSharedPointer<RoomInfoListItem>(room_item);
 
-                if (current_avatar != new_avatar && !new_avatar.toString().isEmpty())
-                        client_->fetchRoomAvatar(room_id, new_avatar);
+        updateUnreadNotifications(room, registry_->unreadNotifications(room));
 
-                room->setState(state);
-        }
+        int pos = contentsLayout_->count() - 1;
+        contentsLayout_->insertWidget(pos, room_item);
 }
 
 void
@@ -162,24 +185,27 @@ RoomList::highlightSelectedRoom(const QString &room_id)
 {
         emit roomChanged(room_id);
 
-        if (!rooms_.contains(room_id)) {
+        auto selected = registry_->handle(room_id);
+
+        if (item(selected).isNull()) {
                 qDebug() << "RoomList: clicked unknown roomid";
                 return;
         }
 
-        // TODO: Send a read receipt for the last event.
-        auto room = rooms_[room_id];
-        room->clearUnreadMessageCount();
+        // The read marker of the room is sent with a delay, so the counts are
+        // cleared locally until the server sends the new ones.
+        registry_->setUnreadNotifications(selected, UnreadNotifications());
 
-        calculateUnreadMessageCount();
+        for (RoomHandle room = 0; room < rooms_.size(); ++room) {
+                if (rooms_[room].isNull())
+                        continue;
 
-        for (auto it = rooms_.constBegin(); it != rooms_.constEnd(); it++) {
-                if (it.key() != room_id) {
-                        it.value()->setPressedState(false);
+                if (room != selected) {
+                        rooms_[room]->setPressedState(false);
                 } else {
-                        it.value()->setPressedState(true);
+                        rooms_[room]->setPressedState(true);
                         scrollArea_->ensureWidgetVisible(
-                          qobject_cast<QWidget *>(it.value().data()));
+                          qobject_cast<QWidget *>(rooms_[room].data()));
                 }
         }
 }
@@ -187,21 +213,44 @@ RoomList::highlightSelectedRoom(const QString &room_id)
 void
 RoomList::updateRoomAvatar(const QString &roomid, const QPixmap &img)
 {
-        if (!rooms_.contains(roomid)) {
+        auto room = item(registry_->handle(roomid));
+
+        if (room.isNull()) {
                 qWarning() << "Avatar update on non existent room" << roomid;
                 return;
         }
 
-        rooms_.value(roomid)->setAvatar(img.toImage());
+        room->setAvatar(img.toImage());
 }
 
 void
 RoomList::updateRoomDescription(const QString &roomid, const DescInfo &info)
 {
-        if (!rooms_.contains(roomid)) {
+        auto room = item(registry_->handle(roomid));
+
+        if (room.isNull()) {
                 qWarning() << "Description update on non existent room" << roomid << info.body;
                 return;
         }
 
-        rooms_.value(roomid)->setDescriptionMessage(info);
+        room->setDescriptionMessage(info);
+}
+
+void
+RoomList::updateRoomName(RoomHandle room)
+{
+        if (item(room).isNull())
+                return;
+
+        item(room)->update();
+}
+
+void
+RoomList::updateRoomAvatarUrl(RoomHandle room, const QUrl &avatar_url)
+{
+        if (item(room).isNull())
+                return;
+
+        if (!avatar_url.toString().isEmpty())
+                client_->fetchRoomAvatar(registry_->roomId(room), avatar_url);
 }
@@ -0,0 +1,191 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include <utility>
+
+#include "RoomRegistry.h"
+
+const RoomHandle RoomRegistry::InvalidRoom;
+
+RoomRegistry::RoomRegistry(QObject *parent)
+  : QObject(parent)
+{
+}
+
+RoomHandle
+RoomRegistry::insert(const QString &room_id, RoomState state)
+{
+        auto room = handle(room_id);
+
+        if (room != InvalidRoom) {
+                *states_[room] = std::move(state);
+                return room;
+        }
+
+        room = ids_.size();
+
+        handles_.insert(room_id, room);
+        ids_.append(room_id);
+        states_.append(QSharedPointer<RoomState>(new RoomState(std::move(state))));
+        settings_.append(QSharedPointer<RoomSettings>(new RoomSettings(room_id)));
+        avatars_.append(QPixmap());
+        unread_.append(UnreadNotifications());
+
+        return room;
+}
+
+void
+RoomRegistry::update(RoomHandle room, const JoinedRoom &data)
+{
+        if (!contains(room))
+                return;
+
+        auto state = states_[room];
+
+        const auto aliases_id         = state->aliases.eventId();
+        const auto avatar_id          = state->avatar.eventId();
+        const auto canonical_alias_id = state->canonical_alias.eventId();
+        const auto name_id            = state->name.eventId();
+
+        const auto old_name   = state->getName();
+        const auto old_topic  = state->getTopic();
+        const auto old_avatar = state->getAvatar();
+
+        bool members_changed = state->updateFromEvents(data.state().events());
+
+        if (state->updateFromEvents(data.timeline().events()))
+                members_changed = true;
+
+        const bool summary_changed = !data.summary().isEmpty();
+
+        if (summary_changed)
+                state->summary.updateFromServer(data.summary());
+
+        setUnreadNotifications(room, data.unreadNotifications());
+
+        if (members_changed)
+                state->removeLeaveMemberships();
+
+        const bool needs_name = members_changed || summary_changed ||
+                                aliases_id != state->aliases.eventId() ||
+                                canonical_alias_id != state->canonical_alias.eventId() ||
+                                name_id != state->name.eventId();
+
+        // The room avatar might be taken from a member, so it depends on the name.
+        if (needs_name)
+                state->resolveName();
+
+        if (needs_name || avatar_id != state->avatar.eventId())
+                state->resolveAvatar();
+
+        if (members_changed)
+                emit membersChanged(room);
+
+        if (state->getName() != old_name)
+                emit nameChanged(room, state->getName());
+
+        if (state->getTopic() != old_topic)
+                emit topicChanged(room, state->getTopic());
+
+        if (state->getAvatar() != old_avatar)
+                emit avatarChanged(room, state->getAvatar());
+}
+
+void
+RoomRegistry::remove(RoomHandle room)
+{
+        if (!contains(room))
+                return;
+
+        setUnreadNotifications(room, UnreadNotifications());
+
+        handles_.remove(ids_[room]);
+
+        ids_[room].clear();
+        states_[room].reset();
+        settings_[room].reset();
+        avatars_[room] = QPixmap();
+}
+
+void
+RoomRegistry::setAvatar(RoomHandle room, const QPixmap &img)
+{
+        if (!contains(room))
+                return;
+
+        avatars_[room] = img;
+}
+
+void
+RoomRegistry::setUnreadNotifications(RoomHandle room, const UnreadNotifications &counts)
+{
+        if (!contains(room) || unread_[room] == counts)
+                return;
+
+        int notifications_diff = 0;
+
+        if (settings_[room]->isNotificationsEnabled())
+                notifications_diff = counts.notificationCount() - unread_[room].notificationCount();
+
+        total_notifications_ += notifications_diff;
+
+        unread_[room] = counts;
+
+        emit unreadNotificationsChanged(room, counts);
+
+        if (notifications_diff != 0)
+                emit totalNotificationCountChanged(total_notifications_);
+}
+
+void
+RoomRegistry::notificationsToggled(RoomHandle room)
+{
+        if (!contains(room))
+                return;
+
+        const int count = unread_[room].notificationCount();
+
+        // The count is added back when the room is unmuted.
+        const int notifications_diff = settings_[room]->isNotificationsEnabled() ? count : -count;
+
+        total_notifications_ += notifications_diff;
+
+        emit unreadNotificationsChanged(room, unread_[room]);
+
+        if (notifications_diff != 0)
+                emit totalNotificationCountChanged(total_notifications_);
+}
+
+void
+RoomRegistry::clear()
+{
+        const bool had_notifications = total_notifications_ != 0;
+
+        handles_.clear();
+        ids_.clear();
+        states_.clear();
+        settings_.clear();
+        avatars_.clear();
+        unread_.clear();
+
+        total_notifications_ = 0;
+
+        if (had_notifications)
+                emit totalNotificationCountChanged(0);
+}
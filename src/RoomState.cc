@@ -17,7 +17,8 @@
 
 #include <QDebug>
 #include <QJsonArray>
-#include <QSettings>
+
+#include <utility>
 
 #include "RoomState.h"
 
@@ -27,7 +28,7 @@ void
 RoomState::resolveName()
 {
         name_ = "Empty Room";
-        userAvatar_.clear();
+        userAvatar_ = matrix::Identifier();
 
         if (!name.content().name().isEmpty()) {
                 name_ = name.content().name().simplified();
@@ -45,29 +46,13 @@ RoomState::resolveName()
                 return;
         }
 
-        QSettings settings;
-        auto user_id = settings.value("auth/user_id");
-
-        // TODO: Display names should be sorted alphabetically.
-        for (const auto membership : memberships) {
-                if (membership.stateKey() == user_id)
-                        continue;
-
-                if (membership.content().membershipState() == events::Membership::Join) {
-                        userAvatar_ = membership.stateKey();
+        // Name the room after its heroes.
+        name_ = summary.name(display_names);
 
-                        if (membership.content().displayName().isEmpty())
-                                name_ = membership.stateKey();
-                        else
-                                name_ = membership.content().displayName();
-
-                        break;
-                }
-        }
+        auto heroes = summary.heroes();
 
-        // TODO: pluralization
-        if (memberships.size() > 2)
-                name_ = QString("%1 and %2 others").arg(name_).arg(memberships.size());
+        if (!heroes.isEmpty())
+                userAvatar_ = heroes.first();
 }
 
 void
@@ -81,7 +66,8 @@ RoomState::resolveAvatar()
         if (memberships.contains(userAvatar_)) {
                 avatar_ = memberships[userAvatar_].content().avatarUrl();
         } else {
-                qWarning() << "Setting room avatar from unknown user id" << userAvatar_;
+                qWarning() << "Setting room avatar from unknown user id"
+                           << userAvatar_.toString();
         }
 }
 
@@ -138,11 +124,21 @@ RoomState::update(const RoomState &state)
         for (auto it = state.memberships.constBegin(); it != state.memberships.constEnd(); ++it) {
                 auto membershipState = it.value().content().membershipState();
 
+                auto previous = this->memberships.constFind(it.key());
+                summary.update(it.key(),
+                               previous == this->memberships.constEnd()
+                                 ? events::Membership::Leave
+                                 : previous.value().content().membershipState(),
+                               membershipState);
+
                 if (it.key() == userAvatar_) {
                         needsNameCalculation   = true;
                         needsAvatarCalculation = true;
                 }
 
+                display_names.update(it.key(), it.value().content());
+                changed_members.insert(it.key());
+
                 if (membershipState == events::Membership::Leave)
                         this->memberships.remove(it.key());
                 else
@@ -188,6 +184,8 @@ RoomState::serialize() const
         if (!topic.eventId().isEmpty())
                 obj["topic"] = topic.serialize();
 
+        obj["summary"] = summary.serialize();
+
         return obj;
 }
 
@@ -201,7 +199,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["aliases"]);
-                        aliases = event;
+                        aliases = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - aliases" << e.what();
                 }
@@ -212,7 +210,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["avatar"]);
-                        avatar = event;
+                        avatar = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - avatar" << e.what();
                 }
@@ -223,7 +221,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["canonical_alias"]);
-                        canonical_alias = event;
+                        canonical_alias = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - canonical_alias" << e.what();
                 }
@@ -234,7 +232,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["create"]);
-                        create = event;
+                        create = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - create" << e.what();
                 }
@@ -245,7 +243,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["history_visibility"]);
-                        history_visibility = event;
+                        history_visibility = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - history_visibility" << e.what();
                 }
@@ -256,7 +254,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["join_rules"]);
-                        join_rules = event;
+                        join_rules = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - join_rules" << e.what();
                 }
@@ -267,7 +265,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["name"]);
-                        name = event;
+                        name = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - name" << e.what();
                 }
@@ -278,7 +276,7 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["power_levels"]);
-                        power_levels = event;
+                        power_levels = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - power_levels" << e.what();
                 }
@@ -289,16 +287,20 @@ RoomState::parse(const QJsonObject &object)
 
                 try {
                         event.deserialize(object["topic"]);
-                        topic = event;
+                        topic = std::move(event);
                 } catch (const DeserializationException &e) {
                         qWarning() << "RoomState::parse - topic" << e.what();
                 }
         }
+
+        if (object.contains("summary"))
+                summary.updateFromServer(object["summary"].toObject());
 }
 
-void
+bool
 RoomState::updateFromEvents(const QJsonArray &events)
 {
+        bool members_changed = false;
         events::EventType ty;
 
         for (const auto &event : events) {
@@ -317,65 +319,77 @@ RoomState::updateFromEvents(const QJsonArray &events)
                         case events::EventType::RoomAliases: {
                                 events::StateEvent<events::AliasesEventContent> aliases;
                                 aliases.deserialize(event);
-                                this->aliases = aliases;
+                                this->aliases = std::move(aliases);
                                 break;
                         }
                         case events::EventType::RoomAvatar: {
                                 events::StateEvent<events::AvatarEventContent> avatar;
                                 avatar.deserialize(event);
-                                this->avatar = avatar;
+                                this->avatar = std::move(avatar);
                                 break;
                         }
                         case events::EventType::RoomCanonicalAlias: {
                                 events::StateEvent<events::CanonicalAliasEventContent>
                                   canonical_alias;
                                 canonical_alias.deserialize(event);
-                                this->canonical_alias = canonical_alias;
+                                this->canonical_alias = std::move(canonical_alias);
                                 break;
                         }
                         case events::EventType::RoomCreate: {
                                 events::StateEvent<events::CreateEventContent> create;
                                 create.deserialize(event);
-                                this->create = create;
+                                this->create = std::move(create);
                                 break;
                         }
                         case events::EventType::RoomHistoryVisibility: {
                                 events::StateEvent<events::HistoryVisibilityEventContent>
                                   history_visibility;
                                 history_visibility.deserialize(event);
-                                this->history_visibility = history_visibility;
+                                this->history_visibility = std::move(history_visibility);
                                 break;
                         }
                         case events::EventType::RoomJoinRules: {
                                 events::StateEvent<events::JoinRulesEventContent> join_rules;
                                 join_rules.deserialize(event);
-                                this->join_rules = join_rules;
+                                this->join_rules = std::move(join_rules);
                                 break;
                         }
                         case events::EventType::RoomName: {
                                 events::StateEvent<events::NameEventContent> name;
                                 name.deserialize(event);
-                                this->name = name;
+                                this->name = std::move(name);
                                 break;
                         }
                         case events::EventType::RoomMember: {
                                 events::StateEvent<events::MemberEventContent> member;
                                 member.deserialize(event);
 
-                                this->memberships.insert(member.stateKey(), member);
+                                auto user_id  = member.stateKeyHandle();
+                                auto previous = this->memberships.constFind(user_id);
+
+                                this->summary.update(
+                                  user_id,
+                                  previous == this->memberships.constEnd()
+                                    ? events::Membership::Leave
+                                    : previous.value().content().membershipState(),
+                                  member.content().membershipState());
+                                this->display_names.update(user_id, member.content());
+                                this->memberships[user_id] = std::move(member);
+                                this->changed_members.insert(user_id);
+                                members_changed = true;
 
                                 break;
                         }
                         case events::EventType::RoomPowerLevels: {
                                 events::StateEvent<events::PowerLevelsEventContent> power_levels;
                                 power_levels.deserialize(event);
-                                this->power_levels = power_levels;
+                                this->power_levels = std::move(power_levels);
                                 break;
                         }
                         case events::EventType::RoomTopic: {
                                 events::StateEvent<events::TopicEventContent> topic;
                                 topic.deserialize(event);
-                                this->topic = topic;
+                                this->topic = std::move(topic);
                                 break;
                         }
                         default: {
@@ -387,4 +401,6 @@ RoomState::updateFromEvents(const QJsonArray &events)
                         continue;
                 }
         }
+
+        return members_changed;
 }
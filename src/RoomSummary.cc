@@ -0,0 +1,170 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QJsonArray>
+#include <QObject>
+#include <QStringList>
+
+#include "DisplayNameIndex.h"
+#include "RoomSummary.h"
+
+const int RoomSummary::MaxHeroes;
+
+static matrix::Identifier LOCAL_USER;
+
+void
+RoomSummary::setLocalUser(const matrix::Identifier &user_id)
+{
+        LOCAL_USER = user_id;
+}
+
+static bool
+isMember(events::Membership membership)
+{
+        return membership == events::Membership::Join ||
+               membership == events::Membership::Invite;
+}
+
+void
+RoomSummary::update(const matrix::Identifier &user_id,
+                    events::Membership previous,
+                    events::Membership current)
+{
+        if (previous == current)
+                return;
+
+        if (previous == events::Membership::Join)
+                joined_ -= 1;
+        else if (previous == events::Membership::Invite)
+                invited_ -= 1;
+
+        if (current == events::Membership::Join)
+                joined_ += 1;
+        else if (current == events::Membership::Invite)
+                invited_ += 1;
+
+        if (user_id == LOCAL_USER)
+                return;
+
+        if (isMember(current))
+                members_.insert(user_id.toString(), user_id);
+        else
+                members_.remove(user_id.toString());
+}
+
+void
+RoomSummary::updateFromServer(const QJsonObject &summary)
+{
+        // Each field is only sent when it changed.
+        if (summary.contains("m.heroes")) {
+                server_heroes_.clear();
+
+                for (const auto &hero : summary.value("m.heroes").toArray()) {
+                        auto user_id = matrix::Identifier(hero.toString());
+
+                        if (user_id != LOCAL_USER)
+                                server_heroes_.append(user_id);
+                }
+        }
+
+        if (summary.contains("m.joined_member_count"))
+                server_joined_ = summary.value("m.joined_member_count").toInt();
+
+        if (summary.contains("m.invited_member_count"))
+                server_invited_ = summary.value("m.invited_member_count").toInt();
+}
+
+QJsonObject
+RoomSummary::serialize() const
+{
+        QJsonObject summary;
+
+        if (!server_heroes_.isEmpty()) {
+                QJsonArray heroes;
+
+                for (const auto &hero : server_heroes_)
+                        heroes.append(hero.toString());
+
+                summary["m.heroes"] = heroes;
+        }
+
+        if (server_joined_ >= 0)
+                summary["m.joined_member_count"] = server_joined_;
+
+        if (server_invited_ >= 0)
+                summary["m.invited_member_count"] = server_invited_;
+
+        return summary;
+}
+
+QList<matrix::Identifier>
+RoomSummary::heroes() const
+{
+        if (!server_heroes_.isEmpty())
+                return server_heroes_;
+
+        QList<matrix::Identifier> heroes;
+
+        for (auto it = members_.constBegin(); it != members_.constEnd(); ++it) {
+                if (heroes.size() == MaxHeroes)
+                        break;
+
+                heroes.append(it.value());
+        }
+
+        return heroes;
+}
+
+int
+RoomSummary::joinedMemberCount() const
+{
+        return server_joined_ < 0 ? joined_ : server_joined_;
+}
+
+int
+RoomSummary::invitedMemberCount() const
+{
+        return server_invited_ < 0 ? invited_ : server_invited_;
+}
+
+QString
+RoomSummary::name(const DisplayNameIndex &names) const
+{
+        const auto heroes = this->heroes();
+
+        if (heroes.isEmpty())
+                return "Empty Room";
+
+        QStringList hero_names;
+
+        for (const auto &hero : heroes)
+                hero_names.append(names.displayName(hero));
+
+        // Everyone but the local user.
+        const int others = joinedMemberCount() + invitedMemberCount() - 1;
+
+        if (others > hero_names.size())
+                return QObject::tr("%1 and %n other(s)", "", others - hero_names.size())
+                  .arg(hero_names.join(", "));
+
+        if (hero_names.size() == 1)
+                return hero_names.first();
+
+        auto last = hero_names.takeLast();
+
+        return QObject::tr("%1 and %2").arg(hero_names.join(", ")).arg(last);
+}
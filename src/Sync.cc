@@ -81,6 +81,97 @@ Rooms::deserialize(const QJsonValue &data)
                         qWarning() << "Skipping malformed object for room" << it.key();
                 }
         }
+
+        auto invite = object.value("invite").toObject();
+
+        for (auto it = invite.constBegin(); it != invite.constEnd(); it++) {
+                InvitedRoom tmp_room;
+
+                try {
+                        tmp_room.deserialize(it.value());
+                        invite_.insert(it.key(), tmp_room);
+                } catch (DeserializationException &e) {
+                        qWarning() << e.what();
+                        qWarning() << "Skipping malformed object for invited room" << it.key();
+                }
+        }
+
+        auto leave = object.value("leave").toObject();
+
+        for (auto it = leave.constBegin(); it != leave.constEnd(); it++) {
+                LeftRoom tmp_room;
+
+                try {
+                        tmp_room.deserialize(it.value());
+                        leave_.insert(it.key(), tmp_room);
+                } catch (DeserializationException &e) {
+                        qWarning() << e.what();
+                        qWarning() << "Skipping malformed object for left room" << it.key();
+                }
+        }
+}
+
+void
+InvitedRoom::deserialize(const QJsonValue &data)
+{
+        if (!data.isObject())
+                throw DeserializationException("InvitedRoom is not a JSON object");
+
+        QJsonObject object = data.toObject();
+
+        if (!object.value("invite_state").isObject())
+                throw DeserializationException("invite/invite_state should be an object");
+
+        auto invite_state = object.value("invite_state").toObject();
+
+        if (!invite_state.value("events").isArray())
+                throw DeserializationException("invite/invite_state/events is not an array");
+
+        invite_state_ = invite_state.value("events").toArray();
+}
+
+void
+LeftRoom::deserialize(const QJsonValue &data)
+{
+        if (!data.isObject())
+                throw DeserializationException("LeftRoom is not a JSON object");
+
+        QJsonObject object = data.toObject();
+
+        // Both sections are optional for rooms we left.
+        if (object.value("state").isObject()) {
+                auto state = object.value("state").toObject();
+
+                if (state.contains("events"))
+                        state_.deserialize(state.value("events"));
+        }
+
+        if (object.value("timeline").isObject())
+                timeline_.deserialize(object.value("timeline"));
+}
+
+QJsonObject
+UnreadNotifications::serialize() const
+{
+        QJsonObject object;
+
+        object["highlight_count"]    = highlight_count_;
+        object["notification_count"] = notification_count_;
+
+        return object;
+}
+
+void
+UnreadNotifications::deserialize(const QJsonValue &data)
+{
+        if (!data.isObject())
+                throw DeserializationException("unread_notifications should be an object");
+
+        QJsonObject object = data.toObject();
+
+        // Both counts are omitted when they are zero.
+        highlight_count_    = object.value("highlight_count").toInt(0);
+        notification_count_ = object.value("notification_count").toInt(0);
 }
 
 void
@@ -113,6 +204,10 @@ JoinedRoom::deserialize(const QJsonValue &data)
 
         state_.deserialize(state.value("events"));
         timeline_.deserialize(object.value("timeline"));
+        unread_notifications_.deserialize(object.value("unread_notifications"));
+
+        if (object.value("summary").isObject())
+                summary_ = object.value("summary").toObject();
 }
 
 void
@@ -165,6 +260,18 @@ State::deserialize(const QJsonValue &data)
         events_ = data.toArray();
 }
 
+QJsonObject
+Timeline::serialize() const
+{
+        QJsonObject object;
+
+        object["events"]     = events_;
+        object["prev_batch"] = prev_batch_;
+        object["limited"]    = limited_;
+
+        return object;
+}
+
 void
 Timeline::deserialize(const QJsonValue &data)
 {
@@ -0,0 +1,685 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QAbstractItemView>
+#include <QAbstractTextDocumentLayout>
+#include <QDateTime>
+#include <QDebug>
+#include <QDesktopServices>
+#include <QMouseEvent>
+#include <QPainter>
+#include <QPainterPath>
+#include <QSet>
+
+#include <algorithm>
+#include <cmath>
+
+#include "AvatarProvider.h"
+#include "BodyFormatter.h"
+#include "Config.h"
+#include "ImageOverlayDialog.h"
+#include "TimelineDelegate.h"
+
+const int TimelineDelegate::MaxImageWidth   = 500;
+const int TimelineDelegate::MaxImageHeight  = 300;
+const int TimelineDelegate::ImageTextHeight = 30;
+const int TimelineDelegate::DefaultMemoryBudget = 64 * 1024;
+const int TimelineDelegate::WidthBucket         = 16;
+const int TimelineDelegate::HeightCacheSize     = 20000;
+
+// A rough estimate of the memory of a parsed body and its layout, in KiB.
+static int
+layoutCost(const QTextDocument *doc)
+{
+        return 1 + doc->characterCount() / 16;
+}
+
+// The rows span the whole viewport, whatever the option says.
+static int
+rowWidth(const QStyleOptionViewItem &option)
+{
+        auto view = qobject_cast<const QAbstractItemView *>(option.widget);
+
+        if (view == nullptr)
+                return option.rect.width();
+
+        return view->viewport()->width();
+}
+
+static void
+openUrl(const QUrl &url)
+{
+        if (!QDesktopServices::openUrl(url))
+                qWarning() << "Could not open url" << url.toString();
+}
+
+TimelineDelegate::TimelineDelegate(QSharedPointer<MatrixClient> client,
+                                   QSharedPointer<RoomState> state,
+                                   QObject *parent)
+  : QStyledItemDelegate(parent)
+  , heights_{ HeightCacheSize }
+  , client_{ client }
+  , state_{ state }
+{
+        setMemoryBudget(DefaultMemoryBudget);
+
+        font_.setPixelSize(conf::fontSize);
+
+        sender_font_ = font_;
+        sender_font_.setBold(true);
+
+        timestamp_font_.setPixelSize(conf::timeline::fonts::timestamp);
+
+        connect(client_.data(),
+                &MatrixClient::imageDownloaded,
+                this,
+                &TimelineDelegate::imageDownloaded);
+}
+
+TimelineDelegate::RowLayout
+TimelineDelegate::layoutRow(const QStyleOptionViewItem &option, const TimelineEntry &entry) const
+{
+        using namespace conf::timeline;
+
+        const int left  = option.rect.left() + msgMargin;
+        const int top   = option.rect.top() + (entry.with_sender ? msgMargin : msgMargin / 3);
+        const int x     = left + avatarSize + headerLeftMargin;
+        const int width = std::max(0, option.rect.left() + rowWidth(option) - x - msgMargin);
+
+        RowLayout row;
+
+        if (entry.with_sender) {
+                row.avatar = QRect(left, top, avatarSize, avatarSize);
+                row.header = QRect(x, top, width, QFontMetrics(sender_font_).height());
+        } else {
+                row.avatar = QRect(left, top, avatarSize, QFontMetrics(font_).height());
+                row.header = QRect(x, top, width, 0);
+        }
+
+        int height = 0;
+
+        if (entry.kind == TimelineEntry::Kind::Image) {
+                height = imageSize(entry).height();
+        } else {
+                height = bodyHeight(entry, width);
+        }
+
+        row.body = QRect(x, row.header.top() + row.header.height(), width, height);
+
+        return row;
+}
+
+TimelineDelegate::BodyKey
+TimelineDelegate::bodyKey(const TimelineEntry &entry) const
+{
+        // The local echoes don't have an event yet.
+        if (entry.event_id.isEmpty())
+                return BodyKey(QString("txn:%1").arg(entry.txn_id), font_.key());
+
+        return BodyKey(entry.event_id, font_.key());
+}
+
+QTextDocument *
+TimelineDelegate::parseBody(const TimelineEntry &entry) const
+{
+        auto doc = new QTextDocument;
+        doc->setDefaultFont(font_);
+        doc->setDocumentMargin(0);
+        doc->setHtml(formatBody(entry));
+
+        return doc;
+}
+
+QTextDocument *
+TimelineDelegate::layoutBody(const TimelineEntry &entry, int width) const
+{
+        const auto key    = bodyKey(entry);
+        const auto bucket = width - width % WidthBucket;
+
+        auto doc = layouts_.object(key);
+
+        if (doc == nullptr) {
+                doc = parseBody(entry);
+
+                // The cache deletes the documents that exceed the budget.
+                if (!layouts_.insert(key, doc, layoutCost(doc))) {
+                        uncached_layout_.reset(parseBody(entry));
+                        doc = uncached_layout_.data();
+                }
+        }
+
+        if (doc->textWidth() != bucket)
+                doc->setTextWidth(bucket);
+
+        return doc;
+}
+
+int
+TimelineDelegate::bodyHeight(const TimelineEntry &entry, int width) const
+{
+        const auto key    = bodyKey(entry);
+        const auto bucket = width - width % WidthBucket;
+
+        auto heights = heights_.object(key);
+
+        if (heights != nullptr) {
+                auto it = heights->constFind(bucket);
+                if (it != heights->constEnd())
+                        return it.value();
+
+                // Forget the widths of a previous resize.
+                if (heights->size() > 8)
+                        heights->clear();
+        } else {
+                heights = new BodyHeights;
+                heights_.insert(key, heights);
+        }
+
+        auto doc = layouts_.object(key);
+
+        // The rows are measured far from the viewport too. Their bodies are
+        // only kept while there is room for them, without evicting the ones
+        // that are painted.
+        QScopedPointer<QTextDocument> measured;
+
+        if (doc == nullptr) {
+                doc = parseBody(entry);
+
+                const int cost = layoutCost(doc);
+
+                if (layouts_.totalCost() + cost <= layouts_.maxCost())
+                        layouts_.insert(key, doc, cost);
+                else
+                        measured.reset(doc);
+        }
+
+        doc->setTextWidth(bucket);
+
+        auto height = static_cast<int>(std::ceil(doc->size().height()));
+        heights->insert(bucket, height);
+
+        return height;
+}
+
+QString
+TimelineDelegate::formatBody(const TimelineEntry &entry) const
+{
+        const bool is_notice = entry.kind == TimelineEntry::Kind::Notice;
+
+        QString html = "<span style=\"color: #171717;\">";
+
+        if (is_notice)
+                html += "<i style=\"color: #565E5E\">";
+
+        if (entry.kind == TimelineEntry::Kind::Emote) {
+                html += "* ";
+                appendBodyHtml(html, senderName(entry));
+                html += " ";
+        }
+
+        appendBodyHtml(html, entry.body.trimmed());
+
+        if (is_notice)
+                html += "</i>";
+
+        html += "</span>";
+
+        return html;
+}
+
+QString
+TimelineDelegate::senderName(const TimelineEntry &entry) const
+{
+        auto name = state_->display_names.displayName(entry.sender);
+
+        // Show the localpart of a user without a display name.
+        if (name.startsWith("@") && name.contains(":"))
+                return name.mid(1, name.indexOf(":") - 1);
+
+        return name;
+}
+
+QSize
+TimelineDelegate::sizeHint(const QStyleOptionViewItem &option, const QModelIndex &index) const
+{
+        const auto &row_entry = entry(index);
+        const int width       = rowWidth(option);
+
+        if (row_entry.kind == TimelineEntry::Kind::Gap)
+                return QSize(width, QFontMetrics(font_).height() + 2 * conf::timeline::msgMargin);
+
+        QStyleOptionViewItem opt = option;
+        opt.rect                 = QRect(0, 0, width, 0);
+
+        auto row   = layoutRow(opt, row_entry);
+        int height = row.body.bottom() + 1;
+
+        if (row_entry.with_sender)
+                height = std::max(height, row.avatar.bottom() + 1);
+
+        return QSize(width, height);
+}
+
+void
+TimelineDelegate::paint(QPainter *painter,
+                        const QStyleOptionViewItem &option,
+                        const QModelIndex &index) const
+{
+        const auto &row_entry = entry(index);
+
+        painter->save();
+        painter->setRenderHint(QPainter::Antialiasing);
+        painter->setRenderHint(QPainter::SmoothPixmapTransform);
+
+        if (option.state & QStyle::State_Selected)
+                painter->fillRect(option.rect, QColor("#f2f5f8"));
+
+        if (row_entry.kind == TimelineEntry::Kind::Gap) {
+                paintGap(painter, option.rect, row_entry);
+                painter->restore();
+                return;
+        }
+
+        if (row_entry.is_failed)
+                painter->setOpacity(0.5);
+
+        auto row  = layoutRow(option, row_entry);
+        auto time = QDateTime::fromMSecsSinceEpoch(row_entry.timestamp).toString("HH:mm");
+
+        QFontMetrics timestamp_metrics(timestamp_font_);
+
+        if (row_entry.with_sender) {
+                paintAvatar(painter, row.avatar, row_entry);
+
+                QFontMetrics sender_metrics(sender_font_);
+
+                auto name = sender_metrics.elidedText(
+                  senderName(row_entry), Qt::ElideRight, row.header.width());
+                auto baseline = row.header.top() + sender_metrics.ascent();
+
+                painter->setFont(sender_font_);
+                painter->setPen(QColor("#171717"));
+                painter->drawText(QPoint(row.header.left(), baseline), name);
+
+                painter->setFont(timestamp_font_);
+                painter->setPen(QColor("#5d6565"));
+                painter->drawText(QPoint(row.header.left() + sender_metrics.width(name) +
+                                           conf::timeline::headerSpacing,
+                                         baseline),
+                                  time);
+        } else {
+                // Align the end of the timestamp with the end of the avatars,
+                // so that the bodies of all the rows are aligned.
+                auto baseline = row.body.top() + QFontMetrics(font_).ascent();
+
+                painter->setFont(timestamp_font_);
+                painter->setPen(QColor("#5d6565"));
+                painter->drawText(
+                  QPoint(row.avatar.right() + 1 - timestamp_metrics.width(time), baseline), time);
+        }
+
+        if (row_entry.kind == TimelineEntry::Kind::Image) {
+                paintImage(painter, option, row.body, index);
+        } else {
+                painter->translate(row.body.topLeft());
+                layoutBody(row_entry, row.body.width())->drawContents(painter);
+        }
+
+        painter->restore();
+}
+
+void
+TimelineDelegate::paintAvatar(QPainter *painter,
+                              const QRect &rect,
+                              const TimelineEntry &row_entry) const
+{
+        auto img = AvatarProvider::avatar(row_entry.sender);
+
+        if (!img.isNull()) {
+                QPainterPath path;
+                path.addEllipse(rect);
+
+                painter->save();
+                painter->setClipPath(path);
+                painter->drawImage(rect, img);
+                painter->restore();
+
+                return;
+        }
+
+        auto name = senderName(row_entry);
+
+        painter->setPen(Qt::NoPen);
+        painter->setBrush(QColor("#eee"));
+        painter->drawEllipse(rect);
+
+        if (name.isEmpty())
+                return;
+
+        painter->setFont(font_);
+        painter->setPen(QColor("black"));
+        painter->drawText(rect, Qt::AlignCenter, QString(name.at(0).toUpper()));
+}
+
+void
+TimelineDelegate::paintGap(QPainter *painter, const QRect &rect, const TimelineEntry &gap) const
+{
+        auto text = gap.is_fetching ? tr("Loading missing messages...") : tr("Missing messages");
+
+        painter->setFont(font_);
+        painter->setPen(QColor("#9e9e9e"));
+        painter->drawText(rect, Qt::AlignCenter, text);
+}
+
+void
+TimelineDelegate::paintImage(QPainter *painter,
+                             const QStyleOptionViewItem &option,
+                             const QRect &rect,
+                             const QModelIndex &index) const
+{
+        const auto &row_entry = entry(index);
+        const auto img        = image(index);
+
+        QFontMetrics metrics(font_);
+
+        // The file name is shown until the image is downloaded, over the
+        // space of the image if its size is known.
+        if (img.isNull()) {
+                auto text_rect = rect;
+
+                if (row_entry.image_size.isValid()) {
+                        auto target = QRect(rect.topLeft(), imageSize(row_entry));
+                        painter->fillRect(target, QColor("#eee"));
+
+                        text_rect = target.adjusted(5, 0, -5, 0);
+                }
+
+                auto text = metrics.elidedText(
+                  row_entry.body, Qt::ElideRight, std::min(text_rect.width(), MaxImageWidth - 10));
+
+                painter->setFont(font_);
+                painter->setPen(QColor(66, 133, 244));
+                painter->drawText(text_rect, Qt::AlignLeft | Qt::AlignVCenter, text);
+
+                return;
+        }
+
+        auto target = QRect(rect.topLeft(), imageSize(row_entry));
+        painter->drawPixmap(target, img);
+
+        if (!(option.state & QStyle::State_MouseOver))
+                return;
+
+        auto text_rect = QRect(
+          target.left(), target.bottom() + 1 - ImageTextHeight, target.width(), ImageTextHeight);
+        painter->fillRect(text_rect, QColor(33, 33, 33, 128));
+
+        QFont text_font = font_;
+        text_font.setWeight(QFont::DemiBold);
+
+        painter->setFont(text_font);
+        painter->setPen(QColor("white"));
+        painter->drawText(text_rect.adjusted(5, 0, -5, 0),
+                          Qt::AlignLeft | Qt::AlignVCenter,
+                          metrics.elidedText(row_entry.body, Qt::ElideRight, target.width() - 10));
+}
+
+QPixmap
+TimelineDelegate::image(const QModelIndex &index) const
+{
+        const auto &url = entry(index).url;
+
+        if (auto img = images_.object(url))
+                return *img;
+
+        auto &rows = requested_[url];
+
+        if (rows.isEmpty()) {
+                auto download_url = downloadUrl(url);
+
+                if (download_url.isEmpty()) {
+                        requested_.remove(url);
+                        return QPixmap();
+                }
+
+                client_->downloadImage(url, download_url);
+        }
+
+        if (!rows.contains(index))
+                rows.append(index);
+
+        return QPixmap();
+}
+
+QSize
+TimelineDelegate::imageSize(const TimelineEntry &row_entry) const
+{
+        auto size = image_sizes_.value(row_entry.url, row_entry.image_size);
+
+        if (!size.isValid())
+                return QSize(MaxImageWidth, QFontMetrics(font_).height() + 10);
+
+        // Only shrink the images that don't fit.
+        if (size.width() > MaxImageWidth || size.height() > MaxImageHeight)
+                size.scale(MaxImageWidth, MaxImageHeight, Qt::KeepAspectRatio);
+
+        return size;
+}
+
+QUrl
+TimelineDelegate::downloadUrl(const QString &mxc_url) const
+{
+        auto url_parts = mxc_url.split("mxc://");
+
+        if (url_parts.size() != 2) {
+                qDebug() << "Invalid format for image" << mxc_url;
+                return QUrl();
+        }
+
+        return QUrl(QString("%1/_matrix/media/r0/download/%2")
+                      .arg(client_->getHomeServer().toString(), url_parts[1]));
+}
+
+void
+TimelineDelegate::setImage(const QString &url, const QPixmap &img)
+{
+        if (img.isNull())
+                return;
+
+        image_sizes_.insert(url, img.size());
+
+        // 4 bytes per pixel.
+        images_.insert(url, new QPixmap(img), std::max(1, img.width() * img.height() / 256));
+}
+
+void
+TimelineDelegate::setMemoryBudget(int budget)
+{
+        // Most of the memory goes to the images.
+        layouts_.setMaxCost(budget / 8);
+        images_.setMaxCost(budget - budget / 8);
+}
+
+void
+TimelineDelegate::releaseRowsOutside(const TimelineModel *model, int first, int last)
+{
+        QSet<BodyKey> layouts;
+        QSet<QString> images;
+        QSet<QString> sizes;
+
+        for (int row = 0; row < model->rowCount(); ++row) {
+                const auto &row_entry = model->entry(row);
+                const bool in_window  = row >= first && row <= last;
+
+                if (row_entry.kind == TimelineEntry::Kind::Image) {
+                        if (in_window)
+                                images.insert(row_entry.url);
+
+                        // A released row only needs the size of its image when
+                        // the event didn't carry it.
+                        if (in_window ||
+                            row_entry.image_size != image_sizes_.value(row_entry.url))
+                                sizes.insert(row_entry.url);
+                } else if (in_window && row_entry.kind != TimelineEntry::Kind::Gap) {
+                        layouts.insert(bodyKey(row_entry));
+                }
+        }
+
+        for (const auto &url : images_.keys()) {
+                if (!images.contains(url))
+                        images_.remove(url);
+        }
+
+        for (auto it = image_sizes_.begin(); it != image_sizes_.end();) {
+                if (sizes.contains(it.key()))
+                        ++it;
+                else
+                        it = image_sizes_.erase(it);
+        }
+
+        // The layouts are what keeps a resize cheap, so they are only
+        // released once they take half of their budget.
+        if (layouts_.totalCost() <= layouts_.maxCost() / 2)
+                return;
+
+        for (const auto &key : layouts_.keys()) {
+                if (!layouts.contains(key))
+                        layouts_.remove(key);
+        }
+}
+
+void
+TimelineDelegate::displayNamesChanged(const TimelineModel *model)
+{
+        for (int row = 0; row < model->rowCount(); ++row) {
+                const auto &row_entry = model->entry(row);
+
+                if (row_entry.kind != TimelineEntry::Kind::Emote)
+                        continue;
+
+                const auto key = bodyKey(row_entry);
+
+                layouts_.remove(key);
+                heights_.remove(key);
+
+                emit sizeHintChanged(model->index(row));
+        }
+}
+
+void
+TimelineDelegate::imageDownloaded(const QString &url, const QPixmap &img)
+{
+        // Another room requested it.
+        if (!requested_.contains(url))
+                return;
+
+        const auto rows = requested_.take(url);
+
+        // The sizes that the rows reserved for the image.
+        QList<QSize> reserved;
+        for (const auto &index : rows)
+                reserved.append(index.isValid() ? imageSize(entry(index)) : QSize());
+
+        setImage(url, img);
+
+        // Only the rows without the right size in the info of their event
+        // have to be laid out again.
+        for (int ii = 0; ii < rows.size(); ++ii) {
+                const auto &index = rows.at(ii);
+
+                if (!index.isValid())
+                        continue;
+
+                if (imageSize(entry(index)) == reserved.at(ii))
+                        emit repaintNeeded(index);
+                else
+                        emit sizeHintChanged(index);
+        }
+}
+
+QUrl
+TimelineDelegate::linkAt(const QStyleOptionViewItem &option,
+                         const QModelIndex &index,
+                         const QPoint &pos) const
+{
+        const auto &row_entry = entry(index);
+
+        if (row_entry.kind == TimelineEntry::Kind::Gap)
+                return QUrl();
+
+        auto row = layoutRow(option, row_entry);
+
+        if (row_entry.kind == TimelineEntry::Kind::Image) {
+                if (QRect(row.body.topLeft(), imageSize(row_entry)).contains(pos))
+                        return downloadUrl(row_entry.url);
+
+                return QUrl();
+        }
+
+        if (!row.body.contains(pos))
+                return QUrl();
+
+        auto doc    = layoutBody(row_entry, row.body.width());
+        auto anchor = doc->documentLayout()->anchorAt(pos - row.body.topLeft());
+
+        if (anchor.isEmpty())
+                return QUrl();
+
+        return QUrl(anchor);
+}
+
+bool
+TimelineDelegate::editorEvent(QEvent *event,
+                              QAbstractItemModel *model,
+                              const QStyleOptionViewItem &option,
+                              const QModelIndex &index)
+{
+        if (event->type() != QEvent::MouseButtonRelease)
+                return QStyledItemDelegate::editorEvent(event, model, option, index);
+
+        auto mouse_event = static_cast<QMouseEvent *>(event);
+
+        if (mouse_event->button() != Qt::LeftButton)
+                return false;
+
+        auto url = linkAt(option, index, mouse_event->pos());
+
+        if (url.isEmpty())
+                return false;
+
+        const auto &row_entry = entry(index);
+        auto img              = images_.object(row_entry.url);
+
+        // Clicking on an image opens it, except for the strip with its name.
+        if (row_entry.kind == TimelineEntry::Kind::Image && img != nullptr) {
+                auto rect = layoutRow(option, row_entry).body;
+                rect.setSize(imageSize(row_entry));
+                rect.setTop(rect.bottom() + 1 - ImageTextHeight);
+
+                if (!rect.contains(mouse_event->pos())) {
+                        auto image_dialog =
+                          new ImageOverlayDialog(*img, const_cast<QWidget *>(option.widget));
+                        image_dialog->show();
+
+                        return true;
+                }
+        }
+
+        openUrl(url);
+
+        return true;
+}
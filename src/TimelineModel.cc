@@ -0,0 +1,210 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QDebug>
+
+#include "Deserializable.h"
+#include "Event.h"
+#include "Image.h"
+#include "Instantiations.h"
+#include "MessageEvent.h"
+#include "MessageEventContent.h"
+#include "TimelineModel.h"
+
+namespace events = matrix::events;
+namespace msgs   = matrix::events::messages;
+
+TimelineModel::TimelineModel(QObject *parent)
+  : QAbstractListModel(parent)
+{
+}
+
+int
+TimelineModel::rowCount(const QModelIndex &parent) const
+{
+        if (parent.isValid())
+                return 0;
+
+        return entries_.size();
+}
+
+QVariant
+TimelineModel::data(const QModelIndex &index, int role) const
+{
+        if (!index.isValid() || index.row() >= entries_.size())
+                return QVariant();
+
+        const auto &entry = entries_.at(index.row());
+
+        switch (role) {
+        case Qt::DisplayRole:
+                if (entry.kind == TimelineEntry::Kind::Gap)
+                        return QVariant();
+
+                return entry.body;
+        case Qt::ToolTipRole:
+                if (entry.is_failed)
+                        return tr("The message couldn't be sent");
+
+                return QVariant();
+        default:
+                return QVariant();
+        }
+}
+
+bool
+TimelineModel::parseEntry(const QJsonObject &event, TimelineEntry &entry)
+{
+        if (events::extractEventType(event) != events::EventType::RoomMessage)
+                return false;
+
+        switch (events::extractMessageEventType(event)) {
+        case events::MessageEventType::Text:
+                entry.kind = TimelineEntry::Kind::Text;
+                break;
+        case events::MessageEventType::Notice:
+                entry.kind = TimelineEntry::Kind::Notice;
+                break;
+        case events::MessageEventType::Emote:
+                entry.kind = TimelineEntry::Kind::Emote;
+                break;
+        case events::MessageEventType::Image:
+                entry.kind = TimelineEntry::Kind::Image;
+                break;
+        case events::MessageEventType::Unknown:
+                qWarning() << "Unknown message type" << event;
+                return false;
+        default:
+                return false;
+        }
+
+        events::RoomEvent<events::MessageEventContent> msg;
+
+        try {
+                msg.deserialize(event);
+
+                if (entry.kind == TimelineEntry::Kind::Image) {
+                        msgs::Image image;
+                        image.deserialize(event.value("content").toObject());
+
+                        entry.url = image.url();
+
+                        if (image.info().w > 0 && image.info().h > 0)
+                                entry.image_size = QSize(image.info().w, image.info().h);
+                }
+        } catch (const DeserializationException &e) {
+                qWarning() << e.what() << event;
+                return false;
+        }
+
+        entry.timestamp = msg.timestamp();
+        entry.sender    = msg.senderHandle();
+        entry.event_id  = msg.eventId();
+        entry.body      = msg.content().body();
+
+        auto transaction_id = event.value("unsigned").toObject().value("transaction_id");
+
+        bool has_txn_id = false;
+        int txn_id      = transaction_id.toString().toInt(&has_txn_id);
+
+        if (has_txn_id)
+                entry.txn_id = txn_id;
+
+        return true;
+}
+
+QList<TimelineEntry>
+TimelineModel::parseEntries(const QJsonArray &events, int count)
+{
+        QList<TimelineEntry> entries;
+        entries.reserve(count);
+
+        for (int ii = 0; ii < count && ii < events.size(); ++ii) {
+                TimelineEntry entry;
+
+                if (parseEntry(events.at(ii).toObject(), entry))
+                        entries.append(entry);
+        }
+
+        return entries;
+}
+
+void
+TimelineModel::append(const QList<TimelineEntry> &entries)
+{
+        insert(entries_.size(), entries);
+}
+
+void
+TimelineModel::prepend(const QList<TimelineEntry> &entries)
+{
+        insert(0, entries);
+}
+
+void
+TimelineModel::insert(int row, const QList<TimelineEntry> &entries)
+{
+        if (entries.isEmpty())
+                return;
+
+        beginInsertRows(QModelIndex(), row, row + entries.size() - 1);
+
+        if (row == entries_.size()) {
+                entries_.append(entries);
+        } else {
+                // Splice the page in with one pass over the rows below it,
+                // instead of shifting them once per inserted entry.
+                QList<TimelineEntry> spliced;
+                spliced.reserve(entries_.size() + entries.size());
+
+                spliced.append(entries_.mid(0, row));
+                spliced.append(entries);
+                spliced.append(entries_.mid(row));
+
+                entries_.swap(spliced);
+        }
+
+        endInsertRows();
+}
+
+void
+TimelineModel::remove(int row)
+{
+        beginRemoveRows(QModelIndex(), row, row);
+        entries_.removeAt(row);
+        endRemoveRows();
+}
+
+void
+TimelineModel::update(int row, const TimelineEntry &entry)
+{
+        entries_[row] = entry;
+
+        auto idx = index(row);
+        emit dataChanged(idx, idx);
+}
+
+int
+TimelineModel::lastMessageRow() const
+{
+        for (int row = entries_.size() - 1; row >= 0; --row) {
+                if (entries_.at(row).kind != TimelineEntry::Kind::Gap)
+                        return row;
+        }
+
+        return -1;
+}
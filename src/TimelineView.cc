@@ -14,53 +14,84 @@
  * You should have received a copy of the GNU General Public License
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
-
+#include <QApplication>
+#include <QClipboard>
+#include <QDateTime>
 #include <QDebug>
+#include <QFileInfo>
+#include <QFutureWatcher>
 #include <QJsonArray>
+#include <QMouseEvent>
 #include <QScrollBar>
 #include <QSettings>
-#include <QtWidgets/QLabel>
-#include <QtWidgets/QSpacerItem>
+#include <QShortcut>
+#include <QTimer>
+#include <QtConcurrent>
+
+#include <algorithm>
 
 #include "Event.h"
 #include "MessageEvent.h"
 #include "MessageEventContent.h"
 
-#include "ImageItem.h"
-#include "TimelineItem.h"
 #include "TimelineView.h"
 #include "TimelineViewManager.h"
 
 namespace events = matrix::events;
 namespace msgs   = matrix::events::messages;
 
+static QString
+descriptiveTime(const QDateTime &then)
+{
+        auto now = QDateTime::currentDateTime();
+
+        auto days = then.daysTo(now);
+
+        if (days == 0)
+                return then.toString("HH:mm");
+        else if (days < 2)
+                return QString("Yesterday");
+        else if (days < 365)
+                return then.toString("dd/MM");
+
+        return then.toString("dd/MM/yy");
+}
+
 TimelineView::TimelineView(const Timeline &timeline,
                            QSharedPointer<MatrixClient> client,
+                           QSharedPointer<RoomState> state,
                            const QString &room_id,
                            QWidget *parent)
   : QWidget(parent)
   , room_id_{ room_id }
   , client_{ client }
+  , state_{ state }
 {
         QSettings settings;
-        local_user_ = settings.value("auth/user_id").toString();
+        local_user_ = matrix::Identifier(settings.value("auth/user_id").toString());
 
         init();
         addEvents(timeline);
 }
 
 TimelineView::TimelineView(QSharedPointer<MatrixClient> client,
+                           QSharedPointer<RoomState> state,
                            const QString &room_id,
                            QWidget *parent)
   : QWidget(parent)
   , room_id_{ room_id }
   , client_{ client }
+  , state_{ state }
 {
         QSettings settings;
-        local_user_ = settings.value("auth/user_id").toString();
+        local_user_ = matrix::Identifier(settings.value("auth/user_id").toString());
 
         init();
-        client_->messages(room_id_, "");
+
+        // The history starts from the newest event. A limited sync that
+        // arrives after the first page leaves a gap.
+        isInitialSync = false;
+        requestHistory();
 }
 
 void
@@ -68,54 +99,77 @@ TimelineView::sliderRangeChanged(int min, int max)
 {
         Q_UNUSED(min);
 
-        if (!scroll_area_->verticalScrollBar()->isVisible()) {
-                scroll_area_->verticalScrollBar()->setValue(max);
+        if (!scrollbar_->isVisible()) {
+                scrollbar_->setValue(max);
                 return;
         }
 
-        if (max - scroll_area_->verticalScrollBar()->value() < SCROLL_BAR_GAP)
-                scroll_area_->verticalScrollBar()->setValue(max);
+        if (max - scrollbar_->value() < SCROLL_BAR_GAP)
+                scrollbar_->setValue(max);
 
-        if (isPaginationScrollPending_) {
-                isPaginationScrollPending_ = false;
+        fetchVisibleGaps();
+        release_timer_->start();
+}
 
-                int currentHeight = scroll_widget_->size().height();
-                int diff          = currentHeight - oldHeight_;
-                int newPosition   = oldPosition_ + diff;
+void
+TimelineView::fetchHistory()
+{
+        // A failed page is requested again when the retry timer fires.
+        if (isTimelineFinished || isPaginationInProgress_ || retry_timer_->isActive())
+                return;
 
-                // Keep the scroll bar to the bottom if we are coming from
-                // an scrollbar without height i.e scrollbar->value() == 0
-                if (oldPosition_ == 0)
-                        newPosition = max;
+        // The content above the viewport should last until the next page
+        // arrives, with a screen to spare.
+        const double remaining = scrollbar_->value();
+        const double needed =
+          list_->viewport()->height() + scroll_velocity_ * pagination_latency_;
 
-                scroll_area_->verticalScrollBar()->setValue(newPosition);
-        }
+        if (remaining < needed)
+                requestHistory();
 }
 
 void
-TimelineView::fetchHistory()
+TimelineView::requestHistory()
 {
-        bool hasEnoughMessages = scroll_area_->verticalScrollBar()->value() != 0;
+        isPaginationInProgress_ = true;
+        pagination_clock_.start();
 
-        if (!hasEnoughMessages && !isTimelineFinished) {
-                isPaginationInProgress_ = true;
-                client_->messages(room_id_, prev_batch_token_);
-                paginationTimer_->start(500);
+        client_->messages(room_id_, prev_batch_token_);
+}
+
+void
+TimelineView::updateScrollVelocity(int position)
+{
+        const qint64 now = scroll_clock_.elapsed();
+        const qint64 dt  = now - last_scroll_time_;
+        const int moved  = last_scroll_position_ - position;
+
+        last_scroll_time_     = now;
+        last_scroll_position_ = position;
+
+        // The content was moved under the viewport, not scrolled.
+        if (is_restoring_scroll_ || dt <= 0)
                 return;
-        }
 
-        paginationTimer_->stop();
+        // Only scrolling towards the history counts.
+        const double velocity = std::max(0, moved) / static_cast<double>(dt);
+
+        // A pause starts a new gesture.
+        if (dt > ScrollGestureTimeout)
+                scroll_velocity_ = velocity;
+        else
+                scroll_velocity_ = (scroll_velocity_ + velocity) / 2;
 }
 
 void
 TimelineView::scrollDown()
 {
-        int current = scroll_area_->verticalScrollBar()->value();
-        int max     = scroll_area_->verticalScrollBar()->maximum();
+        int current = scrollbar_->value();
+        int max     = scrollbar_->maximum();
 
         // The first time we enter the room move the scroll bar to the bottom.
         if (!isInitialized) {
-                scroll_area_->verticalScrollBar()->setValue(max);
+                scrollbar_->setValue(max);
                 isInitialized = true;
                 return;
         }
@@ -123,32 +177,118 @@ TimelineView::scrollDown()
         // If the gap is small enough move the scroll bar down. e.g when a new
         // message appears.
         if (max - current < SCROLL_BAR_GAP)
-                scroll_area_->verticalScrollBar()->setValue(max);
+                scrollbar_->setValue(max);
+}
+
+void
+TimelineView::fetchVisibleGaps()
+{
+        if (!isVisible())
+                return;
+
+        const auto viewport = list_->viewport()->rect();
+
+        for (const auto &index : gaps_) {
+                auto gap = model_->entry(index.row());
+
+                if (gap.is_fetching)
+                        continue;
+
+                if (!list_->visualRect(index).intersects(viewport))
+                        continue;
+
+                gap.is_fetching = true;
+                model_->update(index.row(), gap);
+
+                client_->messages(room_id_, gap.prev_batch);
+        }
+}
+
+bool
+TimelineView::isScrolledToBottom() const
+{
+        return !scrollbar_->isVisible() ||
+               scrollbar_->maximum() - scrollbar_->value() < SCROLL_BAR_GAP;
 }
 
 void
 TimelineView::sliderMoved(int position)
 {
-        if (!scroll_area_->verticalScrollBar()->isVisible())
+        updateScrollVelocity(position);
+        fetchVisibleGaps();
+        release_timer_->start();
+
+        if (isScrolledToBottom())
+                emit scrolledToBottom();
+
+        // The user reached the top before the next page arrived.
+        if (position == 0 && scrollbar_->isVisible() && isPaginationInProgress_ &&
+            !top_wait_clock_.isValid())
+                top_wait_clock_.start();
+        else if (position != 0)
+                top_wait_clock_.invalidate();
+
+        fetchHistory();
+}
+
+void
+TimelineView::setMemoryBudget(int budget)
+{
+        delegate_->setMemoryBudget(budget);
+}
+
+void
+TimelineView::displayNamesChanged()
+{
+        delegate_->displayNamesChanged(model_);
+}
+
+void
+TimelineView::releaseFarRows()
+{
+        if (model_->rowCount() == 0)
                 return;
 
-        // The scrollbar is high enough so we can start retrieving old events.
-        if (position < SCROLL_BAR_GAP) {
-                if (isTimelineFinished)
-                        return;
+        const int height = list_->viewport()->height();
+        const int margin = WindowScreens * height;
 
-                // Prevent user from moving up when there is pagination in
-                // progress.
-                // TODO: Keep a map of the event ids to filter out duplicates.
-                if (isPaginationInProgress_)
-                        return;
+        // Points outside of the content don't have a row.
+        auto first = list_->indexAt(QPoint(0, -margin));
+        auto last  = list_->indexAt(QPoint(0, height + margin));
+
+        delegate_->releaseRowsOutside(model_,
+                                      first.isValid() ? first.row() : 0,
+                                      last.isValid() ? last.row() : model_->rowCount() - 1);
+}
+
+int
+TimelineView::findFetchingGap(const QString &prev_batch) const
+{
+        for (const auto &index : gaps_) {
+                const auto &gap = model_->entry(index.row());
+
+                if (gap.is_fetching && gap.prev_batch == prev_batch)
+                        return index.row();
+        }
+
+        return -1;
+}
+
+int
+TimelineView::missingEvents(int gap_row, const QJsonArray &chunk) const
+{
+        const auto &gap = model_->entry(gap_row);
+
+        int missing = 0;
 
-                isPaginationInProgress_ = true;
+        for (; missing < chunk.size(); ++missing) {
+                auto event_id = chunk.at(missing).toObject().value("event_id").toString();
 
-                // FIXME: Maybe move this to TimelineViewManager to remove the
-                // extra calls?
-                client_->messages(room_id_, prev_batch_token_);
+                if (event_id == gap.event_id || isDuplicate(event_id))
+                        break;
         }
+
+        return missing;
 }
 
 void
@@ -157,198 +297,319 @@ TimelineView::addBackwardsEvents(const QString &room_id, const RoomMessages &msg
         if (room_id_ != room_id)
                 return;
 
+        // The start token of a page is the token it was requested from.
+        const int gap_row = findFetchingGap(msgs.start());
+        const bool is_gap = gap_row != -1;
+
+        // e.g the reply of a gap that was removed while it was fetched.
+        if (!is_gap && !isHistoryPage(msgs))
+                return;
+
+        // The chunk of a gap starts with the newest event. Only the events up
+        // to the first one that is already rendered are missing.
+        const int count = is_gap ? missingEvents(gap_row, msgs.chunk()) : msgs.chunk().size();
+
+        using Watcher = QFutureWatcher<QList<TimelineEntry>>;
+        auto watcher  = new Watcher(this);
+
+        connect(watcher, &Watcher::finished, this, [this, watcher, msgs, is_gap, count]() {
+                watcher->deleteLater();
+
+                if (!is_gap) {
+                        if (isHistoryPage(msgs))
+                                addHistoryPage(msgs, watcher->result());
+                        return;
+                }
+
+                // The rows might have moved while the page was parsed.
+                const int row = findFetchingGap(msgs.start());
+
+                if (row != -1)
+                        fillGap(row, msgs, count, watcher->result());
+        });
+
+        // Deserializing the events is the bulk of the work. Only the rows
+        // are checked against the timeline and inserted on the GUI thread.
+        watcher->setFuture(QtConcurrent::run(&TimelineModel::parseEntries, msgs.chunk(), count));
+}
+
+bool
+TimelineView::isHistoryPage(const RoomMessages &msgs) const
+{
+        if (!isPaginationInProgress_)
+                return false;
+
+        // The first page of a timeline without events starts from the
+        // newest event, whatever its token is.
+        return msgs.start() == prev_batch_token_ || prev_batch_token_.isEmpty();
+}
+
+void
+TimelineView::paginationFailed(const QString &room_id, const QString &from_token)
+{
+        if (room_id_ != room_id)
+                return;
+
+        const int gap_row = findFetchingGap(from_token);
+
+        // The gap is requested again the next time it is in view.
+        if (gap_row != -1) {
+                auto gap        = model_->entry(gap_row);
+                gap.is_fetching = false;
+
+                model_->update(gap_row, gap);
+                return;
+        }
+
+        if (!isPaginationInProgress_ || from_token != prev_batch_token_)
+                return;
+
+        isPaginationInProgress_ = false;
+        pagination_clock_.invalidate();
+
+        retry_timer_->start(retry_delay_);
+        retry_delay_ = std::min(2 * retry_delay_, MaxRetryDelay);
+}
+
+void
+TimelineView::addHistoryPage(const RoomMessages &msgs, const QList<TimelineEntry> &parsed)
+{
+        // The first page of a timeline that was created without events.
+        if (last_event_id_.isEmpty() && !msgs.chunk().isEmpty())
+                last_event_id_ = msgs.chunk().first().toObject().value("event_id").toString();
+
+        if (pagination_clock_.isValid()) {
+                // Smoothed, so that a single slow response doesn't dominate.
+                pagination_latency_ = (3 * pagination_latency_ + pagination_clock_.elapsed()) / 4;
+                pagination_clock_.invalidate();
+        }
+
         if (msgs.chunk().count() == 0) {
-                isTimelineFinished = true;
+                isTimelineFinished      = true;
+                isPaginationInProgress_ = false;
+                top_wait_clock_.invalidate();
                 return;
         }
 
         isTimelineFinished = false;
-        QList<TimelineItem *> items;
+        QList<TimelineEntry> entries;
 
-        // Parse in reverse order to determine where we should not show sender's
+        // Go in reverse order to determine where we should not show sender's
         // name.
-        auto ii = msgs.chunk().size();
-        while (ii != 0) {
-                --ii;
+        for (int ii = parsed.size() - 1; ii >= 0; --ii) {
+                auto entry = parsed.at(ii);
 
-                TimelineItem *item =
-                  parseMessageEvent(msgs.chunk().at(ii).toObject(), TimelineDirection::Top);
-
-                if (item != nullptr)
-                        items.push_back(item);
+                if (acceptEntry(entry, TimelineDirection::Top))
+                        entries.push_back(entry);
         }
 
         // Reverse again to render them.
-        std::reverse(items.begin(), items.end());
+        std::reverse(entries.begin(), entries.end());
+
+        insertPage(0, entries);
 
-        oldPosition_ = scroll_area_->verticalScrollBar()->value();
-        oldHeight_   = scroll_widget_->size().height();
+        prev_batch_token_       = msgs.end();
+        isPaginationInProgress_ = false;
 
-        for (const auto &item : items)
-                addTimelineItem(item, TimelineDirection::Top);
+        retry_delay_ = MinRetryDelay;
 
-        prev_batch_token_          = msgs.end();
-        isPaginationInProgress_    = false;
-        isPaginationScrollPending_ = true;
+        if (top_wait_clock_.isValid()) {
+                top_waits_ += 1;
+                top_wait_total_ += top_wait_clock_.elapsed();
+                top_wait_clock_.invalidate();
+        }
 
-        // Exclude the top stretch.
-        if (!msgs.chunk().isEmpty() && scroll_layout_->count() > 1)
-                notifyForLastEvent();
+        notifyForLastEvent();
 
         // If this batch is the first being rendered (i.e the first and the last
         // events originate from this batch), set the last sender.
-        if (lastSender_.isEmpty() && !items.isEmpty())
-                lastSender_ = items.constFirst()->descriptionMessage().userid;
+        if (lastSender_.isEmpty() && !entries.isEmpty())
+                lastSender_ = entries.constLast().sender;
+
+        // Keep the buffer of history filled, e.g when the page didn't fill
+        // the viewport or the user is still scrolling up.
+        fetchHistory();
 }
 
-TimelineItem *
-TimelineView::parseMessageEvent(const QJsonObject &event, TimelineDirection direction)
+void
+TimelineView::fillGap(int row,
+                      const RoomMessages &msgs,
+                      int missing,
+                      const QList<TimelineEntry> &parsed)
 {
-        events::EventType ty = events::extractEventType(event);
+        auto gap        = model_->entry(row);
+        gap.is_fetching = false;
 
-        if (ty == events::EventType::RoomMessage) {
-                events::MessageEventType msg_type = events::extractMessageEventType(event);
+        // The page reached the events that were already rendered.
+        const bool is_closed = msgs.chunk().isEmpty() || missing < msgs.chunk().size();
 
-                if (msg_type == events::MessageEventType::Text) {
-                        events::MessageEvent<msgs::Text> text;
+        // The senders are grouped within the page only.
+        const auto last_sender = lastSender_;
+        lastSender_            = matrix::Identifier();
 
-                        try {
-                                text.deserialize(event);
-                        } catch (const DeserializationException &e) {
-                                qWarning() << e.what() << event;
-                                return nullptr;
-                        }
+        QList<TimelineEntry> entries;
 
-                        if (isDuplicate(text.eventId()))
-                                return nullptr;
+        for (int ii = parsed.size() - 1; ii >= 0; --ii) {
+                auto entry = parsed.at(ii);
+
+                if (acceptEntry(entry, TimelineDirection::Bottom))
+                        entries.push_back(entry);
+        }
 
-                        eventIds_[text.eventId()] = true;
+        lastSender_ = last_sender;
 
-                        if (isPendingMessage(
-                              text.eventId(), text.content().body(), text.sender(), local_user_)) {
-                                removePendingMessage(text.eventId(), text.content().body());
-                                return nullptr;
+        // Older pages are inserted right below the gap, above the newer ones.
+        insertPage(row + 1, entries);
+
+        if (is_closed) {
+                for (int ii = 0; ii < gaps_.size(); ++ii) {
+                        if (gaps_.at(ii).row() == row) {
+                                gaps_.removeAt(ii);
+                                break;
                         }
+                }
 
-                        auto with_sender = isSenderRendered(text.sender(), direction);
+                model_->remove(row);
+                return;
+        }
 
-                        updateLastSender(text.sender(), direction);
+        gap.prev_batch = msgs.end();
+        model_->update(row, gap);
 
-                        return createTimelineItem(text, with_sender);
-                } else if (msg_type == events::MessageEventType::Notice) {
-                        events::MessageEvent<msgs::Notice> notice;
+        // The rest of the gap might still be in view.
+        QTimer::singleShot(0, this, &TimelineView::fetchVisibleGaps);
+}
 
-                        try {
-                                notice.deserialize(event);
-                        } catch (const DeserializationException &e) {
-                                qWarning() << e.what() << event;
-                                return nullptr;
-                        }
+void
+TimelineView::insertPage(int row, const QList<TimelineEntry> &entries)
+{
+        if (entries.isEmpty())
+                return;
 
-                        if (isDuplicate(notice.eventId()))
-                                return nullptr;
+        const bool was_empty = model_->rowCount() == 0;
 
-                        eventIds_[notice.eventId()] = true;
+        QPersistentModelIndex anchor = list_->indexAt(QPoint(0, 0));
+        const int anchor_top         = list_->visualRect(anchor).top();
 
-                        auto with_sender = isSenderRendered(notice.sender(), direction);
+        // Nothing is painted until the scroll position is restored.
+        list_->setUpdatesEnabled(false);
 
-                        updateLastSender(notice.sender(), direction);
+        model_->insert(row, entries);
+        list_->doItemsLayout();
 
-                        return createTimelineItem(notice, with_sender);
-                } else if (msg_type == events::MessageEventType::Image) {
-                        events::MessageEvent<msgs::Image> img;
+        is_restoring_scroll_ = true;
 
-                        try {
-                                img.deserialize(event);
-                        } catch (const DeserializationException &e) {
-                                qWarning() << e.what() << event;
-                                return nullptr;
-                        }
+        if (was_empty || !anchor.isValid())
+                scrollbar_->setValue(scrollbar_->maximum());
+        else
+                scrollbar_->setValue(scrollbar_->value() + list_->visualRect(anchor).top() -
+                                     anchor_top);
 
-                        if (isDuplicate(img.eventId()))
-                                return nullptr;
+        is_restoring_scroll_ = false;
 
-                        eventIds_[img.eventId()] = true;
+        list_->setUpdatesEnabled(true);
+}
 
-                        if (isPendingMessage(
-                              img.eventId(), img.msgContent().url(), img.sender(), local_user_)) {
-                                removePendingMessage(img.eventId(), img.msgContent().url());
-                                return nullptr;
-                        }
+bool
+TimelineView::acceptEntry(TimelineEntry &entry, TimelineDirection direction)
+{
+        if (!eventIds_.insert(entry.event_id))
+                return false;
 
-                        auto with_sender = isSenderRendered(img.sender(), direction);
+        if (confirmLocalEcho(entry))
+                return false;
 
-                        updateLastSender(img.sender(), direction);
+        entry.with_sender = isSenderRendered(entry.sender, direction);
 
-                        return createTimelineItem(img, with_sender);
-                } else if (msg_type == events::MessageEventType::Emote) {
-                        events::MessageEvent<msgs::Emote> emote;
+        updateLastSender(entry.sender, direction);
 
-                        try {
-                                emote.deserialize(event);
-                        } catch (const DeserializationException &e) {
-                                qWarning() << e.what() << event;
-                                return nullptr;
-                        }
+        return true;
+}
 
-                        if (isDuplicate(emote.eventId()))
-                                return nullptr;
+void
+TimelineView::addEvents(const Timeline &timeline)
+{
+        SyncBatch batch;
+        batch.events = timeline.events();
 
-                        eventIds_[emote.eventId()] = true;
+        // Events were skipped between the ones we have and this batch.
+        batch.has_gap = !isInitialSync && timeline.limited() && !last_event_id_.isEmpty() &&
+                        !timeline.events().isEmpty();
 
-                        if (isPendingMessage(emote.eventId(),
-                                             emote.content().body(),
-                                             emote.sender(),
-                                             local_user_)) {
-                                removePendingMessage(emote.eventId(), emote.content().body());
-                                return nullptr;
-                        }
+        if (batch.has_gap) {
+                batch.gap.kind       = TimelineEntry::Kind::Gap;
+                batch.gap.event_id   = last_event_id_;
+                batch.gap.prev_batch = timeline.previousBatch();
+        }
 
-                        auto with_sender = isSenderRendered(emote.sender(), direction);
+        // Known before the events are parsed, e.g for the read markers.
+        if (!timeline.events().isEmpty())
+                last_event_id_ = timeline.events().last().toObject().value("event_id").toString();
 
-                        updateLastSender(emote.sender(), direction);
+        if (isInitialSync) {
+                prev_batch_token_ = timeline.previousBatch();
+                isInitialSync     = false;
 
-                        return createTimelineItem(emote, with_sender);
-                } else if (msg_type == events::MessageEventType::Unknown) {
-                        qWarning() << "Unknown message type" << event;
-                        return nullptr;
-                }
+                requestHistory();
         }
 
-        return nullptr;
+        if (batch.events.isEmpty())
+                return;
+
+        sync_batches_.append(batch);
+
+        // The batches are parsed one at a time, so they are appended in the
+        // order they were received.
+        if (sync_batches_.size() == 1)
+                parseSyncBatch();
 }
 
-int
-TimelineView::addEvents(const Timeline &timeline)
+void
+TimelineView::parseSyncBatch()
 {
-        int message_count = 0;
+        const auto events = sync_batches_.first().events;
 
-        QSettings settings;
-        QString localUser = settings.value("auth/user_id").toString();
+        using Watcher = QFutureWatcher<QList<TimelineEntry>>;
+        auto watcher  = new Watcher(this);
 
-        for (const auto &event : timeline.events()) {
-                TimelineItem *item = parseMessageEvent(event.toObject(), TimelineDirection::Bottom);
+        connect(watcher, &Watcher::finished, this, [this, watcher]() {
+                watcher->deleteLater();
 
-                if (item != nullptr) {
-                        addTimelineItem(item, TimelineDirection::Bottom);
+                appendSyncBatch(sync_batches_.takeFirst(), watcher->result());
 
-                        if (localUser != event.toObject().value("sender").toString())
-                                message_count += 1;
-                }
-        }
+                if (!sync_batches_.isEmpty())
+                        parseSyncBatch();
+        });
 
-        if (isInitialSync) {
-                prev_batch_token_ = timeline.previousBatch();
-                isInitialSync     = false;
+        watcher->setFuture(QtConcurrent::run(&TimelineModel::parseEntries, events, events.size()));
+}
 
-                client_->messages(room_id_, prev_batch_token_);
+void
+TimelineView::appendSyncBatch(const SyncBatch &batch, const QList<TimelineEntry> &parsed)
+{
+        QList<TimelineEntry> entries;
+
+        if (batch.has_gap) {
+                entries.push_back(batch.gap);
+
+                // The next message starts a new group of senders.
+                lastSender_ = matrix::Identifier();
+
+                QTimer::singleShot(0, this, &TimelineView::fetchVisibleGaps);
         }
 
-        // Exclude the top stretch.
-        if (!timeline.events().isEmpty() && scroll_layout_->count() > 1)
-                notifyForLastEvent();
+        for (auto entry : parsed) {
+                if (acceptEntry(entry, TimelineDirection::Bottom))
+                        entries.push_back(entry);
+        }
+
+        const int first_row = model_->rowCount();
+        model_->append(entries);
+
+        if (batch.has_gap)
+                gaps_.append(QPersistentModelIndex(model_->index(first_row)));
 
-        return message_count;
+        notifyForLastEvent();
 }
 
 void
@@ -358,47 +619,117 @@ TimelineView::init()
         top_layout_->setSpacing(0);
         top_layout_->setMargin(0);
 
-        scroll_area_ = new QScrollArea(this);
-        scroll_area_->setWidgetResizable(true);
-        scroll_area_->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
-
-        scrollbar_ = new ScrollBar(scroll_area_);
-        scroll_area_->setVerticalScrollBar(scrollbar_);
+        model_    = new TimelineModel(this);
+        delegate_ = new TimelineDelegate(client_, state_, this);
+
+        list_ = new QListView(this);
+        list_->setModel(model_);
+        list_->setItemDelegate(delegate_);
+        list_->setFrameShape(QFrame::NoFrame);
+        list_->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
+        list_->setVerticalScrollMode(QAbstractItemView::ScrollPerPixel);
+        list_->setResizeMode(QListView::Adjust);
+        list_->setSelectionMode(QAbstractItemView::ExtendedSelection);
+        list_->setEditTriggers(QAbstractItemView::NoEditTriggers);
+        list_->setMouseTracking(true);
+        list_->viewport()->installEventFilter(this);
+
+        connect(delegate_,
+                &TimelineDelegate::repaintNeeded,
+                this,
+                [this](const QModelIndex &index) { list_->update(index); });
 
-        scroll_widget_ = new QWidget();
+        scrollbar_ = new ScrollBar(list_);
+        list_->setVerticalScrollBar(scrollbar_);
 
-        scroll_layout_ = new QVBoxLayout();
-        scroll_layout_->addStretch(1);
-        scroll_layout_->setSpacing(0);
+        top_layout_->addWidget(list_);
 
-        scroll_widget_->setLayout(scroll_layout_);
+        setLayout(top_layout_);
 
-        scroll_area_->setWidget(scroll_widget_);
+        auto copy = new QShortcut(QKeySequence::Copy, list_);
+        copy->setContext(Qt::WidgetShortcut);
+        connect(copy, &QShortcut::activated, this, &TimelineView::copySelection);
 
-        top_layout_->addWidget(scroll_area_);
+        scroll_clock_.start();
 
-        setLayout(top_layout_);
+        retry_timer_ = new QTimer(this);
+        retry_timer_->setSingleShot(true);
+        connect(retry_timer_, &QTimer::timeout, this, &TimelineView::fetchHistory);
 
-        paginationTimer_ = new QTimer(this);
-        connect(paginationTimer_, &QTimer::timeout, this, &TimelineView::fetchHistory);
+        release_timer_ = new QTimer(this);
+        release_timer_->setSingleShot(true);
+        release_timer_->setInterval(ReleaseDelay);
+        connect(release_timer_, &QTimer::timeout, this, &TimelineView::releaseFarRows);
 
         connect(client_.data(),
                 &MatrixClient::messagesRetrieved,
                 this,
                 &TimelineView::addBackwardsEvents);
-
-        connect(scroll_area_->verticalScrollBar(),
-                SIGNAL(valueChanged(int)),
+        connect(client_.data(),
+                &MatrixClient::messagesFailed,
                 this,
-                SLOT(sliderMoved(int)));
-        connect(scroll_area_->verticalScrollBar(),
+                &TimelineView::paginationFailed);
+
+        // The AvatarProvider has cached the avatar by now.
+        connect(client_.data(), &MatrixClient::userAvatarRetrieved, this, [this]() {
+                list_->viewport()->update();
+        });
+
+        connect(scrollbar_, SIGNAL(valueChanged(int)), this, SLOT(sliderMoved(int)));
+        connect(scrollbar_,
                 SIGNAL(rangeChanged(int, int)),
                 this,
                 SLOT(sliderRangeChanged(int, int)));
 }
 
+bool
+TimelineView::eventFilter(QObject *obj, QEvent *event)
+{
+        if (obj != list_->viewport() || event->type() != QEvent::MouseMove)
+                return QWidget::eventFilter(obj, event);
+
+        auto pos   = static_cast<QMouseEvent *>(event)->pos();
+        auto index = list_->indexAt(pos);
+
+        bool is_link = false;
+
+        if (index.isValid()) {
+                QStyleOptionViewItem option;
+                option.rect   = list_->visualRect(index);
+                option.widget = list_;
+
+                is_link = !delegate_->linkAt(option, index, pos).isEmpty();
+        }
+
+        list_->viewport()->setCursor(is_link ? Qt::PointingHandCursor : Qt::ArrowCursor);
+
+        return QWidget::eventFilter(obj, event);
+}
+
+void
+TimelineView::copySelection()
+{
+        auto selected = list_->selectionModel()->selectedRows();
+
+        if (selected.isEmpty())
+                return;
+
+        std::sort(selected.begin(), selected.end());
+
+        QStringList lines;
+
+        for (const auto &index : selected) {
+                auto text = index.data().toString();
+
+                if (!text.isEmpty())
+                        lines.append(text);
+        }
+
+        QApplication::clipboard()->setText(lines.join("\n"));
+}
+
 void
-TimelineView::updateLastSender(const QString &user_id, TimelineDirection direction)
+TimelineView::updateLastSender(const matrix::Identifier &user_id, TimelineDirection direction)
 {
         if (direction == TimelineDirection::Bottom)
                 lastSender_ = user_id;
@@ -407,7 +738,7 @@ TimelineView::updateLastSender(const QString &user_id, TimelineDirection directi
 }
 
 bool
-TimelineView::isSenderRendered(const QString &user_id, TimelineDirection direction)
+TimelineView::isSenderRendered(const matrix::Identifier &user_id, TimelineDirection direction)
 {
         if (direction == TimelineDirection::Bottom)
                 return lastSender_ != user_id;
@@ -415,128 +746,137 @@ TimelineView::isSenderRendered(const QString &user_id, TimelineDirection directi
                 return firstSender_ != user_id;
 }
 
-TimelineItem *
-TimelineView::createTimelineItem(const events::MessageEvent<msgs::Image> &event, bool with_sender)
+void
+TimelineView::updatePendingMessage(int txn_id, QString event_id)
 {
-        auto image = new ImageItem(client_, event);
-        auto item  = new TimelineItem(image, event, with_sender, scroll_widget_);
-
-        return item;
+        if (pending_msgs_.contains(txn_id))
+                pending_event_ids_.insert(event_id, txn_id);
 }
 
-TimelineItem *
-TimelineView::createTimelineItem(const events::MessageEvent<msgs::Notice> &event, bool with_sender)
+void
+TimelineView::markPendingMessageFailed(int txn_id)
 {
-        TimelineItem *item = new TimelineItem(event, with_sender, scroll_widget_);
-        return item;
-}
+        auto index = pending_msgs_.take(txn_id);
 
-TimelineItem *
-TimelineView::createTimelineItem(const events::MessageEvent<msgs::Text> &event, bool with_sender)
-{
-        TimelineItem *item = new TimelineItem(event, with_sender, scroll_widget_);
-        return item;
-}
+        if (!index.isValid())
+                return;
 
-TimelineItem *
-TimelineView::createTimelineItem(const events::MessageEvent<msgs::Emote> &event, bool with_sender)
-{
-        TimelineItem *item = new TimelineItem(event, with_sender, scroll_widget_);
-        return item;
-}
+        auto entry       = model_->entry(index.row());
+        entry.is_pending = false;
+        entry.is_failed  = true;
 
-void
-TimelineView::addTimelineItem(TimelineItem *item, TimelineDirection direction)
-{
-        if (direction == TimelineDirection::Bottom)
-                scroll_layout_->addWidget(item);
-        else
-                scroll_layout_->insertWidget(1, item);
+        model_->update(index.row(), entry);
 }
 
 void
-TimelineView::updatePendingMessage(int txn_id, QString event_id)
+TimelineView::addLocalEcho(const TimelineEntry &entry, int txn_id)
 {
-        for (auto &msg : pending_msgs_) {
-                if (msg.txn_id == txn_id) {
-                        msg.event_id = event_id;
-                        break;
-                }
-        }
+        model_->append({ entry });
+
+        lastSender_ = local_user_;
+
+        pending_msgs_.insert(txn_id, QPersistentModelIndex(model_->index(model_->rowCount() - 1)));
 }
 
 void
 TimelineView::addUserMessage(matrix::events::MessageEventType ty, const QString &body, int txn_id)
 {
-        QSettings settings;
-        auto user_id     = settings.value("auth/user_id").toString();
-        auto with_sender = lastSender_ != user_id;
-
-        TimelineItem *view_item = new TimelineItem(ty, user_id, body, with_sender, scroll_widget_);
-        scroll_layout_->addWidget(view_item);
-
-        lastSender_ = user_id;
-
-        PendingMessage message(txn_id, body, "", view_item);
-        pending_msgs_.push_back(message);
+        TimelineEntry entry;
+        entry.kind        = ty == events::MessageEventType::Emote ? TimelineEntry::Kind::Emote
+                                                                  : TimelineEntry::Kind::Text;
+        entry.with_sender = lastSender_ != local_user_;
+        entry.is_pending  = true;
+        entry.timestamp   = QDateTime::currentMSecsSinceEpoch();
+        entry.sender      = local_user_;
+        entry.body        = body;
+        entry.txn_id      = txn_id;
+
+        addLocalEcho(entry, txn_id);
 }
 
 void
 TimelineView::addUserMessage(const QString &url, const QString &filename, int txn_id)
 {
-        QSettings settings;
-        auto user_id     = settings.value("auth/user_id").toString();
-        auto with_sender = lastSender_ != user_id;
-
-        auto image = new ImageItem(client_, url, filename, this);
-
-        TimelineItem *view_item = new TimelineItem(image, user_id, with_sender, scroll_widget_);
-        scroll_layout_->addWidget(view_item);
-
-        lastSender_ = user_id;
+        TimelineEntry entry;
+        entry.kind        = TimelineEntry::Kind::Image;
+        entry.with_sender = lastSender_ != local_user_;
+        entry.is_pending  = true;
+        entry.timestamp   = QDateTime::currentMSecsSinceEpoch();
+        entry.sender      = local_user_;
+        entry.body        = QFileInfo(filename).fileName();
+        entry.url         = url;
+        entry.txn_id      = txn_id;
+
+        // The uploaded file is shown instead of downloading it back.
+        delegate_->setImage(url, QPixmap(filename));
+
+        addLocalEcho(entry, txn_id);
+}
 
-        PendingMessage message(txn_id, url, "", view_item);
-        pending_msgs_.push_back(message);
+DescInfo
+TimelineView::descriptionMessage(const TimelineEntry &entry,
+                                 const DisplayNameIndex &names,
+                                 const matrix::Identifier &local_user)
+{
+        auto display_name = names.displayName(entry.sender);
+        auto username     = entry.sender == local_user ? QString("You") : display_name;
+        auto timestamp    = descriptiveTime(QDateTime::fromMSecsSinceEpoch(entry.timestamp));
+
+        switch (entry.kind) {
+        case TimelineEntry::Kind::Notice:
+                return { display_name, entry.sender.toString(), " sent a notification", timestamp };
+        case TimelineEntry::Kind::Emote:
+                return { "",
+                         entry.sender.toString(),
+                         QString("* %1 %2").arg(display_name).arg(entry.body.trimmed()),
+                         timestamp };
+        case TimelineEntry::Kind::Image:
+                return { username, entry.sender.toString(), " sent an image", timestamp };
+        default:
+                return { username,
+                         entry.sender.toString(),
+                         QString(": %1").arg(entry.body.trimmed()),
+                         timestamp };
+        }
 }
 
 void
 TimelineView::notifyForLastEvent()
 {
-        auto lastItem          = scroll_layout_->itemAt(scroll_layout_->count() - 1);
-        auto *lastTimelineItem = qobject_cast<TimelineItem *>(lastItem->widget());
+        auto row = model_->lastMessageRow();
 
-        if (lastTimelineItem)
-                emit updateLastTimelineMessage(room_id_, lastTimelineItem->descriptionMessage());
-        else
-                qWarning() << "Cast to TimelineView failed" << room_id_;
+        if (row == -1)
+                return;
+
+        emit updateLastTimelineMessage(
+          room_id_, descriptionMessage(model_->entry(row), state_->display_names, local_user_));
 }
 
 bool
-TimelineView::isPendingMessage(const QString &eventid,
-                               const QString &body,
-                               const QString &sender,
-                               const QString &local_userid)
+TimelineView::confirmLocalEcho(const TimelineEntry &echo)
 {
-        if (sender != local_userid)
+        if (echo.sender != local_user_ || pending_msgs_.isEmpty())
                 return false;
 
-        for (const auto &msg : pending_msgs_) {
-                if (msg.event_id == eventid || msg.body == body)
-                        return true;
-        }
+        const auto &event_id = echo.event_id;
+        int txn_id           = echo.txn_id;
 
-        return false;
-}
+        if (txn_id == -1)
+                txn_id = pending_event_ids_.value(event_id, -1);
 
-void
-TimelineView::removePendingMessage(const QString &eventid, const QString &body)
-{
-        for (auto it = pending_msgs_.begin(); it != pending_msgs_.end(); it++) {
-                int index = std::distance(pending_msgs_.begin(), it);
+        if (!pending_msgs_.contains(txn_id))
+                return false;
 
-                if (it->event_id == eventid || it->body == body) {
-                        pending_msgs_.removeAt(index);
-                        break;
-                }
+        auto index = pending_msgs_.take(txn_id);
+        pending_event_ids_.remove(event_id);
+
+        if (index.isValid()) {
+                auto entry       = model_->entry(index.row());
+                entry.event_id   = event_id;
+                entry.is_pending = false;
+
+                model_->update(index.row(), entry);
         }
+
+        return true;
 }
@@ -15,6 +15,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
 #include <random>
 
 #include <QApplication>
@@ -27,50 +28,89 @@
 #include "TimelineView.h"
 #include "TimelineViewManager.h"
 
-TimelineViewManager::TimelineViewManager(QSharedPointer<MatrixClient> client, QWidget *parent)
+const int TimelineViewManager::MaxViews                = 10;
+const int TimelineViewManager::DefaultRoomMemoryBudget = 64;
+const int TimelineViewManager::DefaultMemoryBudget     = 256;
+
+TimelineViewManager::TimelineViewManager(QSharedPointer<MatrixClient> client,
+                                         QSharedPointer<RoomRegistry> registry,
+                                         QSharedPointer<Outbox> outbox,
+                                         QWidget *parent)
   : QStackedWidget(parent)
   , client_(client)
+  , registry_(registry)
+  , outbox_(outbox)
 {
         setStyleSheet("QWidget { background: #fff; color: #e8e8e8; border: none;}");
 
         connect(
           client_.data(), &MatrixClient::messageSent, this, &TimelineViewManager::messageSent);
+        connect(
+          outbox_.data(), &Outbox::messageFailed, this, &TimelineViewManager::messageFailed);
+        connect(registry_.data(), &RoomRegistry::membersChanged, this, [this](RoomHandle room) {
+                auto view = views_.value(room);
+
+                if (!view.isNull())
+                        view->displayNamesChanged();
+        });
 }
 
 TimelineViewManager::~TimelineViewManager()
 {
 }
 
+void
+TimelineViewManager::setCache(QSharedPointer<Cache> cache)
+{
+        cache_ = cache;
+}
+
 void
 TimelineViewManager::messageSent(const QString &event_id, const QString &roomid, int txn_id)
 {
-        // We save the latest valid transaction ID for later use.
-        QSettings settings;
-        settings.setValue("client/transaction_id", txn_id + 1);
+        auto view = views_.value(registry_->handle(roomid));
+
+        if (view.isNull())
+                return;
 
-        auto view = views_[roomid];
         view->updatePendingMessage(txn_id, event_id);
 }
 
+void
+TimelineViewManager::messageFailed(const QString &roomid, int txn_id)
+{
+        auto view = views_.value(registry_->handle(roomid));
+
+        if (view.isNull())
+                return;
+
+        view->markPendingMessageFailed(txn_id);
+}
+
 void
 TimelineViewManager::sendTextMessage(const QString &msg)
 {
-        auto room_id = active_room_;
-        auto view    = views_[room_id];
+        auto room_id = registry_->roomId(active_room_);
+        auto view    = views_.value(active_room_);
 
-        view->addUserMessage(matrix::events::MessageEventType::Text, msg, client_->transactionId());
-        client_->sendRoomMessage(matrix::events::MessageEventType::Text, room_id, msg);
+        if (view.isNull())
+                return;
+
+        auto txn_id = outbox_->enqueue(room_id, matrix::events::MessageEventType::Text, msg);
+        view->addUserMessage(matrix::events::MessageEventType::Text, msg, txn_id);
 }
 
 void
 TimelineViewManager::sendEmoteMessage(const QString &msg)
 {
-        auto room_id = active_room_;
-        auto view    = views_[room_id];
+        auto room_id = registry_->roomId(active_room_);
+        auto view    = views_.value(active_room_);
+
+        if (view.isNull())
+                return;
 
-        view->addUserMessage(
-          matrix::events::MessageEventType::Emote, msg, client_->transactionId());
-        client_->sendRoomMessage(matrix::events::MessageEventType::Emote, room_id, msg);
+        auto txn_id = outbox_->enqueue(room_id, matrix::events::MessageEventType::Emote, msg);
+        view->addUserMessage(matrix::events::MessageEventType::Emote, msg, txn_id);
 }
 
 void
@@ -78,109 +118,325 @@ TimelineViewManager::sendImageMessage(const QString &roomid,
                                       const QString &filename,
                                       const QString &url)
 {
-        if (!views_.contains(roomid)) {
-                qDebug() << "Cannot send m.image message to a non-managed view";
-                return;
-        }
+        auto view = views_.value(registry_->handle(roomid));
 
-        auto view = views_[roomid];
+        auto txn_id = outbox_->enqueue(
+          roomid, matrix::events::MessageEventType::Image, QFileInfo(filename).fileName(), url);
 
-        view->addUserMessage(url, filename, client_->transactionId());
-        client_->sendRoomMessage(
-          matrix::events::MessageEventType::Image, roomid, QFileInfo(filename).fileName(), url);
+        // The room might have been evicted while the image was uploaded. Its
+        // new view shows the queued message.
+        if (!view.isNull())
+                view->addUserMessage(url, filename, txn_id);
 }
 
 void
 TimelineViewManager::clearAll()
 {
-        for (auto view : views_)
-                removeWidget(view.data());
+        for (auto view : views_) {
+                if (!view.isNull())
+                        removeWidget(view.data());
+        }
 
         views_.clear();
+        recent_rooms_.clear();
+        active_room_ = RoomRegistry::InvalidRoom;
+}
+
+// The transaction IDs of the events that this client sent.
+static QSet<int>
+transactionIds(const QList<Timeline> &batches)
+{
+        QSet<int> txn_ids;
+
+        for (const auto &batch : batches) {
+                for (const auto &event : batch.events()) {
+                        auto txn_id = event.toObject()
+                                        .value("unsigned")
+                                        .toObject()
+                                        .value("transaction_id")
+                                        .toString();
+
+                        bool ok      = false;
+                        const int id = txn_id.toInt(&ok);
+
+                        if (ok)
+                                txn_ids.insert(id);
+                }
+        }
+
+        return txn_ids;
 }
 
 void
-TimelineViewManager::initialize(const Rooms &rooms)
+TimelineViewManager::addView(RoomHandle room,
+                             TimelineView *view,
+                             const QSet<int> &restored_txn_ids)
 {
-        for (auto it = rooms.join().constBegin(); it != rooms.join().constEnd(); it++) {
-                auto roomid = it.key();
+        if (room >= views_.size())
+                views_.resize(room + 1);
+
+        views_[room] = QSharedPointer<TimelineView>(view);
+
+        connect(view,
+                &TimelineView::updateLastTimelineMessage,
+                this,
+                &TimelineViewManager::updateRoomsLastMessage);
+        connect(view, &TimelineView::scrolledToBottom, this, [=]() { markActiveRoomRead(room); });
+
+        // The local echo of the messages that are still queued, e.g from
+        // before a restart or before the view was evicted.
+        for (const auto &msg : outbox_->messages(registry_->roomId(room))) {
+                if (restored_txn_ids.contains(msg.txnId())) {
+                        outbox_->confirm(msg.roomId(), msg.txnId());
+                        continue;
+                }
+
+                if (msg.type() == matrix::events::MessageEventType::Image)
+                        view->addUserMessage(msg.url(), msg.body(), msg.txnId());
+                else
+                        view->addUserMessage(msg.type(), msg.body(), msg.txnId());
+        }
+
+        // Add the view in the widget stack.
+        addWidget(view);
+}
+
+QSharedPointer<TimelineView>
+TimelineViewManager::showView(RoomHandle room)
+{
+        auto view = views_.value(room);
+
+        if (!view.isNull()) {
+                recent_rooms_.removeOne(room);
+                recent_rooms_.prepend(room);
 
-                // Create a history view with the room events.
-                TimelineView *view = new TimelineView(it.value().timeline(), client_, it.key());
-                views_.insert(it.key(), QSharedPointer<TimelineView>(view));
+                return view;
+        }
+
+        if (!registry_->contains(room))
+                return view;
+
+        auto room_id = registry_->roomId(room);
 
-                connect(view,
-                        &TimelineView::updateLastTimelineMessage,
-                        this,
-                        &TimelineViewManager::updateRoomsLastMessage);
+        QList<Timeline> batches;
 
-                // Add the view in the widget stack.
-                addWidget(view);
+        try {
+                if (!cache_.isNull())
+                        batches = cache_->timeline(room_id);
+        } catch (const lmdb::error &e) {
+                qWarning() << "The timeline couldn't be restored from the cache:" << e.what();
         }
+
+        const auto restored_txn_ids = transactionIds(batches);
+
+        // Without any cached events the first page is fetched from the server.
+        if (batches.isEmpty()) {
+                addView(room,
+                        new TimelineView(client_, registry_->state(room), room_id),
+                        restored_txn_ids);
+        } else {
+                auto view =
+                  new TimelineView(batches.takeFirst(), client_, registry_->state(room), room_id);
+
+                // The newer batches are added like the syncs they came from,
+                // so the limited ones leave a gap again.
+                for (const auto &batch : batches)
+                        view->addEvents(batch);
+
+                addView(room, view, restored_txn_ids);
+        }
+
+        recent_rooms_.prepend(room);
+
+        while (recent_rooms_.size() > MaxViews)
+                removeView(recent_rooms_.last());
+
+        updateMemoryBudgets();
+
+        return views_.value(room);
 }
 
 void
-TimelineViewManager::initialize(const QList<QString> &rooms)
+TimelineViewManager::updateMemoryBudgets()
 {
-        for (const auto &roomid : rooms) {
-                // Create a history view without any events.
-                TimelineView *view = new TimelineView(client_, roomid);
-                views_.insert(roomid, QSharedPointer<TimelineView>(view));
+        if (recent_rooms_.isEmpty())
+                return;
+
+        QSettings settings;
+
+        // In MiB.
+        const int room_budget =
+          settings.value("timeline/room_memory_budget", DefaultRoomMemoryBudget).toInt();
+        const int total_budget =
+          settings.value("timeline/memory_budget", DefaultMemoryBudget).toInt();
 
-                connect(view,
-                        &TimelineView::updateLastTimelineMessage,
-                        this,
-                        &TimelineViewManager::updateRoomsLastMessage);
+        // The views share the global budget, up to the budget of a room.
+        const int budget = std::min(room_budget, total_budget / recent_rooms_.size());
 
-                // Add the view in the widget stack.
-                addWidget(view);
+        for (const auto &room : recent_rooms_) {
+                auto view = views_.value(room);
+
+                if (!view.isNull())
+                        view->setMemoryBudget(std::max(1, budget) * 1024);
         }
 }
 
 void
-TimelineViewManager::sync(const Rooms &rooms)
+TimelineViewManager::removeView(RoomHandle room)
 {
+        auto view = views_.value(room);
+
+        recent_rooms_.removeOne(room);
+
+        if (view.isNull())
+                return;
+
+        removeWidget(view.data());
+        views_[room].reset();
+}
+
+void
+TimelineViewManager::updateLastMessage(RoomHandle room, const Timeline &timeline)
+{
+        auto state = registry_->state(room);
+
+        if (state.isNull())
+                return;
+
+        const auto events = timeline.events();
+
+        for (int ii = events.size() - 1; ii >= 0; --ii) {
+                TimelineEntry entry;
+
+                if (!TimelineModel::parseEntry(events.at(ii).toObject(), entry))
+                        continue;
+
+                emit updateRoomsLastMessage(
+                  registry_->roomId(room),
+                  TimelineView::descriptionMessage(entry, state->display_names, local_user_));
+                return;
+        }
+}
+
+void
+TimelineViewManager::initialize(const Rooms &rooms)
+{
+        QSettings settings;
+        local_user_ = matrix::Identifier(settings.value("auth/user_id").toString());
+
         for (auto it = rooms.join().constBegin(); it != rooms.join().constEnd(); it++) {
-                auto roomid = it.key();
+                auto room = registry_->handle(it.key());
 
-                if (!views_.contains(roomid)) {
-                        qDebug() << "Ignoring event from unknown room" << roomid;
+                if (room == RoomRegistry::InvalidRoom) {
+                        qWarning() << "Timeline of an unregistered room" << it.key();
                         continue;
                 }
 
-                auto view = views_.value(roomid);
+                updateLastMessage(room, it.value().timeline());
+        }
+}
 
-                int msgs_added = view->addEvents(it.value().timeline());
+void
+TimelineViewManager::initialize(const QList<QString> &rooms)
+{
+        QSettings settings;
+        local_user_ = matrix::Identifier(settings.value("auth/user_id").toString());
 
-                if (msgs_added > 0) {
-                        // TODO: When the app window gets active the current
-                        // unread count (if any) should be cleared.
-                        auto isAppActive = QApplication::activeWindow() != nullptr;
+        if (cache_.isNull())
+                return;
+
+        QMap<QString, Timeline> timelines;
 
-                        if (roomid != active_room_ || !isAppActive)
-                                emit unreadMessages(roomid, msgs_added);
+        try {
+                timelines = cache_->timelines();
+        } catch (const lmdb::error &e) {
+                qWarning() << "The timelines couldn't be restored from the cache:" << e.what();
+                return;
+        }
+
+        for (const auto &roomid : rooms) {
+                auto room = registry_->handle(roomid);
+
+                if (room == RoomRegistry::InvalidRoom) {
+                        qWarning() << "Timeline of an unregistered room" << roomid;
+                        continue;
                 }
+
+                updateLastMessage(room, timelines.value(roomid));
         }
 }
 
+void
+TimelineViewManager::addRoom(RoomHandle room, const Timeline &timeline)
+{
+        if (!registry_->contains(room))
+                return;
+
+        // The view is created from the cache once the room is shown.
+        updateLastMessage(room, timeline);
+}
+
+void
+TimelineViewManager::removeRoom(RoomHandle room)
+{
+        removeView(room);
+        updateMemoryBudgets();
+
+        if (active_room_ == room)
+                active_room_ = RoomRegistry::InvalidRoom;
+}
+
+void
+TimelineViewManager::sync(RoomHandle room, const Timeline &timeline)
+{
+        auto view = views_.value(room);
+
+        // The events are in the cache for when the room is shown.
+        if (view.isNull()) {
+                updateLastMessage(room, timeline);
+                return;
+        }
+
+        view->addEvents(timeline);
+
+        markActiveRoomRead(room);
+}
+
+void
+TimelineViewManager::markActiveRoomRead(RoomHandle room)
+{
+        auto view = views_.value(room);
+
+        if (room != active_room_ || view.isNull())
+                return;
+
+        if (QApplication::activeWindow() == nullptr || !view->isScrolledToBottom())
+                return;
+
+        emit eventsRead(registry_->roomId(room), view->lastEventId());
+}
+
 void
 TimelineViewManager::setHistoryView(const QString &room_id)
 {
-        if (!views_.contains(room_id)) {
+        auto room = registry_->handle(room_id);
+        auto view = showView(room);
+
+        if (view.isNull()) {
                 qDebug() << "Room ID from RoomList is not present in ViewManager" << room_id;
                 return;
         }
 
-        active_room_ = room_id;
-        auto view    = views_.value(room_id);
+        active_room_ = room;
 
         setCurrentWidget(view.data());
 
         view->fetchHistory();
         view->scrollDown();
-}
+        view->fetchVisibleGaps();
 
-QMap<QString, QString> TimelineViewManager::DISPLAY_NAMES;
+        markActiveRoomRead(room);
+}
 
 QString
 TimelineViewManager::chooseRandomColor()
@@ -239,12 +495,3 @@ TimelineViewManager::chooseRandomColor()
 
         return color.name();
 }
-
-QString
-TimelineViewManager::displayName(const QString &userid)
-{
-        if (DISPLAY_NAMES.contains(userid))
-                return DISPLAY_NAMES.value(userid);
-
-        return userid;
-}
@@ -81,6 +81,7 @@ TopRoomBar::TopRoomBar(QWidget *parent)
         toggleNotifications_ = new QAction(tr("Disable notifications"), this);
         connect(toggleNotifications_, &QAction::triggered, this, [=]() {
                 roomSettings_->toggleNotifications();
+                emit notificationsToggled();
         });
 
         menu_->addAction(toggleNotifications_);
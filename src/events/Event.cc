@@ -23,44 +23,55 @@
 #include "CreateEventContent.h"
 #include "Deserializable.h"
 #include "HistoryVisibilityEventContent.h"
+#include "Identifier.h"
 #include "JoinRulesEventContent.h"
 #include "MemberEventContent.h"
 #include "NameEventContent.h"
 #include "PowerLevelsEventContent.h"
 #include "TopicEventContent.h"
 
+namespace
+{
+// The known event types, keyed by their interned type string.
+const QHash<matrix::Identifier, matrix::events::EventType> &
+eventTypes()
+{
+        using matrix::Identifier;
+        using matrix::events::EventType;
+
+        static const QHash<Identifier, EventType> types = {
+                { Identifier("m.room.aliases"), EventType::RoomAliases },
+                { Identifier("m.room.avatar"), EventType::RoomAvatar },
+                { Identifier("m.room.canonical_alias"), EventType::RoomCanonicalAlias },
+                { Identifier("m.room.create"), EventType::RoomCreate },
+                { Identifier("m.room.history_visibility"), EventType::RoomHistoryVisibility },
+                { Identifier("m.room.join_rules"), EventType::RoomJoinRules },
+                { Identifier("m.room.member"), EventType::RoomMember },
+                { Identifier("m.room.message"), EventType::RoomMessage },
+                { Identifier("m.room.name"), EventType::RoomName },
+                { Identifier("m.room.power_levels"), EventType::RoomPowerLevels },
+                { Identifier("m.room.topic"), EventType::RoomTopic },
+        };
+
+        return types;
+}
+} // namespace
+
 matrix::events::EventType
 matrix::events::extractEventType(const QJsonObject &object)
 {
-        if (!object.contains("type"))
+        const auto value = object.value(QStringLiteral("type"));
+
+        if (value.isUndefined())
                 throw DeserializationException("Missing event type");
 
-        auto type = object.value("type").toString();
+        // Make sure the known types are interned before looking up this one.
+        const auto &types = eventTypes();
+
+        // Unknown types are never interned, so they resolve to the empty identifier.
+        auto type = Identifier::find(value.toString());
 
-        if (type == "m.room.aliases")
-                return EventType::RoomAliases;
-        else if (type == "m.room.avatar")
-                return EventType::RoomAvatar;
-        else if (type == "m.room.canonical_alias")
-                return EventType::RoomCanonicalAlias;
-        else if (type == "m.room.create")
-                return EventType::RoomCreate;
-        else if (type == "m.room.history_visibility")
-                return EventType::RoomHistoryVisibility;
-        else if (type == "m.room.join_rules")
-                return EventType::RoomJoinRules;
-        else if (type == "m.room.member")
-                return EventType::RoomMember;
-        else if (type == "m.room.message")
-                return EventType::RoomMessage;
-        else if (type == "m.room.name")
-                return EventType::RoomName;
-        else if (type == "m.room.power_levels")
-                return EventType::RoomPowerLevels;
-        else if (type == "m.room.topic")
-                return EventType::RoomTopic;
-        else
-                return EventType::Unsupported;
+        return types.value(type, EventType::Unsupported);
 }
 
 bool
@@ -0,0 +1,68 @@
+/*
+ * nheko Copyright (C) 2017  Konstantinos Sideris <siderisk@auth.gr>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Instantiations.h"
+
+namespace matrix
+{
+namespace events
+{
+template class Event<AliasesEventContent>;
+template class Event<AvatarEventContent>;
+template class Event<CanonicalAliasEventContent>;
+template class Event<CreateEventContent>;
+template class Event<HistoryVisibilityEventContent>;
+template class Event<JoinRulesEventContent>;
+template class Event<MemberEventContent>;
+template class Event<MessageEventContent>;
+template class Event<NameEventContent>;
+template class Event<PowerLevelsEventContent>;
+template class Event<TopicEventContent>;
+
+template class RoomEvent<AliasesEventContent>;
+template class RoomEvent<AvatarEventContent>;
+template class RoomEvent<CanonicalAliasEventContent>;
+template class RoomEvent<CreateEventContent>;
+template class RoomEvent<HistoryVisibilityEventContent>;
+template class RoomEvent<JoinRulesEventContent>;
+template class RoomEvent<MemberEventContent>;
+template class RoomEvent<MessageEventContent>;
+template class RoomEvent<NameEventContent>;
+template class RoomEvent<PowerLevelsEventContent>;
+template class RoomEvent<TopicEventContent>;
+
+template class StateEvent<AliasesEventContent>;
+template class StateEvent<AvatarEventContent>;
+template class StateEvent<CanonicalAliasEventContent>;
+template class StateEvent<CreateEventContent>;
+template class StateEvent<HistoryVisibilityEventContent>;
+template class StateEvent<JoinRulesEventContent>;
+template class StateEvent<MemberEventContent>;
+template class StateEvent<NameEventContent>;
+template class StateEvent<PowerLevelsEventContent>;
+template class StateEvent<TopicEventContent>;
+
+template class MessageEvent<messages::Audio>;
+template class MessageEvent<messages::Emote>;
+template class MessageEvent<messages::File>;
+template class MessageEvent<messages::Image>;
+template class MessageEvent<messages::Location>;
+template class MessageEvent<messages::Notice>;
+template class MessageEvent<messages::Text>;
+template class MessageEvent<messages::Video>;
+} // namespace events
+} // namespace matrix
@@ -67,8 +67,9 @@ MessageEventContent::deserialize(const QJsonValue &data)
 QJsonObject
 MessageEventContent::serialize() const
 {
-        // TODO: Add for all the message contents.
         QJsonObject object;
 
+        object["body"] = body_;
+
         return object;
 }
@@ -38,3 +38,22 @@ Audio::deserialize(const QJsonObject &object)
                 info_.size     = info.value("size").toInt();
         }
 }
+
+QJsonObject
+Audio::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.audio";
+        object["url"]     = url_;
+
+        QJsonObject info;
+
+        info["duration"] = static_cast<qint64>(info_.duration);
+        info["mimetype"] = info_.mimetype;
+        info["size"]     = info_.size;
+
+        object["info"] = info;
+
+        return object;
+}
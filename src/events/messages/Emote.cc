@@ -25,3 +25,13 @@ Emote::deserialize(const QJsonObject &object)
         if (object.value("msgtype") != "m.emote")
                 throw DeserializationException("invalid msgtype for emote");
 }
+
+QJsonObject
+Emote::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.emote";
+
+        return object;
+}
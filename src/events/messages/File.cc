@@ -31,7 +31,8 @@ File::deserialize(const QJsonObject &object)
         if (object.value("msgtype") != "m.file")
                 throw DeserializationException("invalid msgtype for file");
 
-        url_ = object.value("url").toString();
+        url_      = object.value("url").toString();
+        filename_ = object.value("filename").toString();
 
         if (object.contains("info")) {
                 auto file_info = object.value("info").toObject();
@@ -50,3 +51,24 @@ File::deserialize(const QJsonObject &object)
                 }
         }
 }
+
+QJsonObject
+File::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"]  = "m.file";
+        object["url"]      = url_;
+        object["filename"] = filename_;
+
+        QJsonObject info;
+
+        info["size"]           = info_.size;
+        info["mimetype"]       = info_.mimetype;
+        info["thumbnail_url"]  = info_.thumbnail_url;
+        info["thumbnail_info"] = serializeThumbnailInfo(info_.thumbnail_info);
+
+        object["info"] = info;
+
+        return object;
+}
@@ -50,3 +50,26 @@ Image::deserialize(const QJsonObject &object)
                 }
         }
 }
+
+QJsonObject
+Image::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.image";
+        object["url"]     = url_;
+
+        QJsonObject info;
+
+        info["w"]    = info_.w;
+        info["h"]    = info_.h;
+        info["size"] = info_.size;
+
+        info["mimetype"]       = info_.mimetype;
+        info["thumbnail_url"]  = info_.thumbnail_url;
+        info["thumbnail_info"] = serializeThumbnailInfo(info_.thumbnail_info);
+
+        object["info"] = info;
+
+        return object;
+}
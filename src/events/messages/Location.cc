@@ -45,3 +45,21 @@ Location::deserialize(const QJsonObject &object)
                 }
         }
 }
+
+QJsonObject
+Location::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.location";
+        object["geo_uri"] = geo_uri_;
+
+        QJsonObject info;
+
+        info["thumbnail_url"]  = info_.thumbnail_url;
+        info["thumbnail_info"] = serializeThumbnailInfo(info_.thumbnail_info);
+
+        object["info"] = info;
+
+        return object;
+}
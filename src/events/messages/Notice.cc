@@ -25,3 +25,13 @@ Notice::deserialize(const QJsonObject &object)
         if (object.value("msgtype") != "m.notice")
                 throw DeserializationException("invalid msgtype for notice");
 }
+
+QJsonObject
+Notice::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.notice";
+
+        return object;
+}
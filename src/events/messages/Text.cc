@@ -25,3 +25,13 @@ Text::deserialize(const QJsonObject &object)
         if (object.value("msgtype") != "m.text")
                 throw DeserializationException("invalid msgtype for text");
 }
+
+QJsonObject
+Text::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.text";
+
+        return object;
+}
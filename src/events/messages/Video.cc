@@ -51,3 +51,27 @@ Video::deserialize(const QJsonObject &object)
                 }
         }
 }
+
+QJsonObject
+Video::serialize() const
+{
+        QJsonObject object;
+
+        object["msgtype"] = "m.video";
+        object["url"]     = url_;
+
+        QJsonObject info;
+
+        info["w"]        = info_.w;
+        info["h"]        = info_.h;
+        info["size"]     = info_.size;
+        info["duration"] = info_.duration;
+
+        info["mimetype"]       = info_.mimetype;
+        info["thumbnail_url"]  = info_.thumbnail_url;
+        info["thumbnail_info"] = serializeThumbnailInfo(info_.thumbnail_info);
+
+        object["info"] = info;
+
+        return object;
+}
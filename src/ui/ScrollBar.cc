@@ -21,7 +21,7 @@
 
 #include "ScrollBar.h"
 
-ScrollBar::ScrollBar(QScrollArea *area, QWidget *parent)
+ScrollBar::ScrollBar(QAbstractScrollArea *area, QWidget *parent)
   : QScrollBar(parent)
   , area_{ area }
 {
@@ -92,8 +92,9 @@ ScrollBar::paintEvent(QPaintEvent *)
         QRect backgroundArea(Padding, 0, handleWidth_, height());
         p.drawRoundedRect(backgroundArea, roundRadius_, roundRadius_);
 
+        // The page step is the height of the viewport.
         int areaHeight   = area_->height();
-        int widgetHeight = area_->widget()->height();
+        int widgetHeight = maximum() - minimum() + pageStep();
 
         double visiblePercentage = (double)areaHeight / (double)widgetHeight;
         int handleHeight = std::max(visiblePercentage * areaHeight, (double)minHandleHeight_);
@@ -0,0 +1,195 @@
+#include <gtest/gtest.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "MessageEvent.h"
+#include "MessageEventContent.h"
+#include "StateEvent.h"
+
+#include "AliasesEventContent.h"
+#include "AvatarEventContent.h"
+#include "CanonicalAliasEventContent.h"
+#include "CreateEventContent.h"
+#include "HistoryVisibilityEventContent.h"
+#include "JoinRulesEventContent.h"
+#include "MemberEventContent.h"
+#include "NameEventContent.h"
+#include "PowerLevelsEventContent.h"
+#include "TopicEventContent.h"
+
+#include "Audio.h"
+#include "Emote.h"
+#include "File.h"
+#include "Image.h"
+#include "Location.h"
+#include "Notice.h"
+#include "Text.h"
+#include "Video.h"
+
+#include "event_fixtures.h"
+
+using namespace matrix::events;
+
+// Heap allocations made by this process. Qt containers and strings allocate
+// through malloc directly, so on glibc the malloc family is interposed as well.
+static std::atomic<std::size_t> allocations{0};
+
+#if defined(__GLIBC__)
+extern "C" {
+void *__libc_malloc(std::size_t size);
+void *__libc_calloc(std::size_t n, std::size_t size);
+void *__libc_realloc(void *ptr, std::size_t size);
+
+void *
+malloc(std::size_t size)
+{
+	++allocations;
+	return __libc_malloc(size);
+}
+
+void *
+calloc(std::size_t n, std::size_t size)
+{
+	++allocations;
+	return __libc_calloc(n, size);
+}
+
+void *
+realloc(void *ptr, std::size_t size)
+{
+	++allocations;
+	return __libc_realloc(ptr, size);
+}
+}
+
+void *
+operator new(std::size_t size)
+{
+	if (void *ptr = malloc(size ? size : 1))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+#else
+void *
+operator new(std::size_t size)
+{
+	++allocations;
+
+	if (void *ptr = std::malloc(size ? size : 1))
+		return ptr;
+
+	throw std::bad_alloc();
+}
+#endif
+
+void
+operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void
+operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+// Heap allocations for decoding one event of each type, counted over the
+// fields that its parser copies out of the fixtures below (the identifiers and
+// the strings of the content, the QString keys built from string literals and
+// the QUrl of the avatars) plus a margin of 4 for the Qt version. They guard
+// against regressions in the event templates (e.g re-extracting objects or
+// copying contents); re-pin them from the failure output when a parser changes.
+
+template<class EventT>
+std::size_t
+decodeAllocations(const QJsonObject &data)
+{
+	// The first decode interns the identifiers and builds the static tables.
+	EventT warmup;
+	warmup.deserialize(data);
+
+	EventT event;
+
+	auto before = allocations.load();
+	event.deserialize(data);
+
+	return allocations.load() - before;
+}
+
+TEST(Allocations, StateEvents)
+{
+	EXPECT_LE(decodeAllocations<StateEvent<AliasesEventContent>>(stateEvent(
+		"m.room.aliases", QJsonObject{{"aliases", QJsonArray{"#test:matrix.org"}}})),
+		13u);
+	EXPECT_LE(decodeAllocations<StateEvent<AvatarEventContent>>(stateEvent(
+		"m.room.avatar", QJsonObject{{"url", "mxc://matrix.org/avatar"}})),
+		16u);
+	EXPECT_LE(decodeAllocations<StateEvent<CanonicalAliasEventContent>>(stateEvent(
+		"m.room.canonical_alias", QJsonObject{{"alias", "#test:matrix.org"}})),
+		12u);
+	EXPECT_LE(decodeAllocations<StateEvent<CreateEventContent>>(stateEvent(
+		"m.room.create", QJsonObject{{"creator", "@alice:matrix.org"}})),
+		12u);
+	EXPECT_LE(decodeAllocations<StateEvent<HistoryVisibilityEventContent>>(stateEvent(
+		"m.room.history_visibility", QJsonObject{{"history_visibility", "shared"}})),
+		12u);
+	EXPECT_LE(decodeAllocations<StateEvent<JoinRulesEventContent>>(stateEvent(
+		"m.room.join_rules", QJsonObject{{"join_rule", "public"}})),
+		12u);
+	EXPECT_LE(decodeAllocations<StateEvent<MemberEventContent>>(stateEvent(
+		"m.room.member", QJsonObject{{"membership", "join"}, {"displayname", "Alice"}})),
+		16u);
+	EXPECT_LE(decodeAllocations<StateEvent<NameEventContent>>(stateEvent(
+		"m.room.name", QJsonObject{{"name", "Room Name"}})),
+		12u);
+	EXPECT_LE(decodeAllocations<StateEvent<PowerLevelsEventContent>>(stateEvent(
+		"m.room.power_levels", QJsonObject{{"ban", 50}, {"kick", 50}})),
+		20u);
+	EXPECT_LE(decodeAllocations<StateEvent<TopicEventContent>>(stateEvent(
+		"m.room.topic", QJsonObject{{"topic", "Room Topic"}})),
+		12u);
+}
+
+TEST(Allocations, MessageEvents)
+{
+	auto info = QJsonObject{
+		{"h", 110},
+		{"w", 220},
+		{"size", 2120},
+		{"duration", 2140786},
+		{"mimetype", "img/jpeg"},
+		{"thumbnail_url", "https://images.com/image-thumb.jpg"},
+		{"thumbnail_info", QJsonObject{{"h", 11}, {"w", 22}, {"size", 212}, {"mimetype", "img/jpeg"}}}};
+
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Audio>>(messageEvent(QJsonObject{
+		{"body", "audio"}, {"msgtype", "m.audio"}, {"url", "mxc://localhost/audio"}, {"info", info}})),
+		24u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Emote>>(messageEvent(QJsonObject{
+		{"body", "emote"}, {"msgtype", "m.emote"}})),
+		14u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::File>>(messageEvent(QJsonObject{
+		{"body", "file"}, {"filename", "file.doc"}, {"msgtype", "m.file"}, {"url", "mxc://localhost/file"}, {"info", info}})),
+		38u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Image>>(messageEvent(QJsonObject{
+		{"body", "image"}, {"msgtype", "m.image"}, {"url", "mxc://localhost/image"}, {"info", info}})),
+		34u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Location>>(messageEvent(QJsonObject{
+		{"body", "location"}, {"msgtype", "m.location"}, {"geo_uri", "geo:37.786971,-122.399677"}, {"info", info}})),
+		28u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Notice>>(messageEvent(QJsonObject{
+		{"body", "notice"}, {"msgtype", "m.notice"}})),
+		14u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Text>>(messageEvent(QJsonObject{
+		{"body", "text"}, {"msgtype", "m.text"}})),
+		14u);
+	EXPECT_LE(decodeAllocations<MessageEvent<messages::Video>>(messageEvent(QJsonObject{
+		{"body", "video"}, {"msgtype", "m.video"}, {"url", "mxc://localhost/video"}, {"info", info}})),
+		35u);
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <QString>
+
+#include "BodyFormatter.h"
+
+static const QString EMOJI_SPAN = "<span style=\"font-family: Emoji One; font-size: 14px\">";
+
+static QString
+format(const QString &body)
+{
+	QString html;
+	appendBodyHtml(html, body);
+
+	return html;
+}
+
+TEST(BodyFormatter, PlainText)
+{
+	EXPECT_EQ(format(""), "");
+	EXPECT_EQ(format("hello world"), "hello world");
+}
+
+TEST(BodyFormatter, Escaping)
+{
+	EXPECT_EQ(format("<b>\"a\" & b</b>"), "&lt;b&gt;&quot;a&quot; &amp; b&lt;/b&gt;");
+	EXPECT_EQ(format("a < b"), QString("a < b").toHtmlEscaped());
+}
+
+TEST(BodyFormatter, Links)
+{
+	EXPECT_EQ(format("see https://matrix.org/docs now"),
+		  "see <a href=\"https://matrix.org/docs\" style=\"color: #333333\">"
+		  "https://matrix.org/docs</a> now");
+	EXPECT_EQ(format("ftp://a"), "<a href=\"ftp://a\" style=\"color: #333333\">ftp://a</a>");
+
+	// The URL is escaped in the link and in its text.
+	EXPECT_EQ(format("http://a.b/?x=1&y=2"),
+		  "<a href=\"http://a.b/?x=1&amp;y=2\" style=\"color: #333333\">"
+		  "http://a.b/?x=1&amp;y=2</a>");
+}
+
+TEST(BodyFormatter, NotLinks)
+{
+	EXPECT_EQ(format("http://"), "http://");
+	EXPECT_EQ(format("http:// a"), "http:// a");
+	EXPECT_EQ(format("https:/a"), "https:/a");
+	EXPECT_EQ(format("mailto:a@b.c"), "mailto:a@b.c");
+}
+
+TEST(BodyFormatter, EmojiRuns)
+{
+	// A run of emoji (including both halves of a surrogate pair) is wrapped once.
+	auto smile = QString::fromUtf8("\xF0\x9F\x98\x80");
+
+	EXPECT_EQ(format("hi " + smile + smile + " there"),
+		  "hi " + EMOJI_SPAN + smile + smile + "</span> there");
+	EXPECT_EQ(format(smile), EMOJI_SPAN + smile + "</span>");
+}
+
+TEST(BodyFormatter, EmojiInLinks)
+{
+	auto smile = QString::fromUtf8("\xF0\x9F\x98\x80");
+
+	// The run is closed before the link and the link text has its own runs.
+	EXPECT_EQ(format(smile + "http://a/" + smile),
+		  EMOJI_SPAN + smile + "</span><a href=\"http://a/" + smile +
+		    "\" style=\"color: #333333\">http://a/" + EMOJI_SPAN + smile + "</span></a>");
+}
+
+TEST(BodyFormatter, Appends)
+{
+	QString html = "<span>";
+	appendBodyHtml(html, "a&b");
+	html += "</span>";
+
+	EXPECT_EQ(html, "<span>a&amp;b</span>");
+}
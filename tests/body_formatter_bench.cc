@@ -0,0 +1,163 @@
+#include <benchmark/benchmark.h>
+
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+
+#include <random>
+
+#include "BodyFormatter.h"
+#include "Config.h"
+
+// Formatting the bodies of the messages for the timeline. The previous
+// formatter, with a pass for the escaping, the links and the emoji, is kept
+// here as the baseline.
+//
+// The corpus is read from the file in NHEKO_BODY_CORPUS (one body per line)
+// when it is set. Otherwise a synthetic one is generated, with the mix of
+// short replies, sentences, links, emoji and code of a typical public room.
+
+static const int CORPUS_SIZE = 100000;
+
+static const QRegExp URL_REGEX("((?:https?|ftp)://\\S+)");
+static const QString URL_HTML = "<a href=\"\\1\" style=\"color: #333333\">\\1</a>";
+
+static QString
+replaceEmoji(const QString &body)
+{
+	QString fmtBody = "";
+
+	for (auto &c : body) {
+		int code = c.unicode();
+
+		if (code > 9000)
+			fmtBody += QString("<span style=\"font-family: Emoji "
+					   "One; font-size: %1px\">")
+				     .arg(conf::emojiSize) +
+				   QString(c) + "</span>";
+		else
+			fmtBody += c;
+	}
+
+	return fmtBody;
+}
+
+static QString
+formatMultiPass(const QString &body)
+{
+	auto html = body.toHtmlEscaped();
+	html.replace(URL_REGEX, URL_HTML);
+	html = replaceEmoji(html);
+
+	return QString("<span style=\"color: #171717;\">%1</span>").arg(html);
+}
+
+static QString
+formatSinglePass(const QString &body)
+{
+	QString html = "<span style=\"color: #171717;\">";
+	appendBodyHtml(html, body);
+	html += "</span>";
+
+	return html;
+}
+
+static QStringList
+syntheticCorpus()
+{
+	const QStringList words = {"the", "a", "to", "it", "is", "and", "I", "you", "that",
+				   "room", "server", "matrix", "sync", "works", "thanks", "now",
+				   "federation", "client", "bridge", "yes", "no", "maybe", "lol"};
+	const QStringList replies = {"ok", "+1", "thanks!", "lol", "yes", "no", "?", "brb"};
+	const QStringList links = {"https://matrix.org/docs/spec/client_server/r0.3.0.html",
+				   "https://github.com/mujx/nheko/issues/42",
+				   "http://example.com/a?b=1&c=2",
+				   "https://www.youtube.com/watch?v=dQw4w9WgXcQ"};
+	const QStringList emoji = {QString::fromUtf8("\xF0\x9F\x98\x80"),
+				   QString::fromUtf8("\xF0\x9F\x91\x8D"),
+				   QString::fromUtf8("\xE2\x9D\xA4"),
+				   QString::fromUtf8("\xF0\x9F\x8E\x89")};
+
+	std::mt19937 gen(42);
+	auto pick = [&gen](const QStringList &list) {
+		return list.at(std::uniform_int_distribution<int>(0, list.size() - 1)(gen));
+	};
+	auto percent = [&gen]() { return std::uniform_int_distribution<int>(0, 99)(gen); };
+
+	QStringList corpus;
+	corpus.reserve(CORPUS_SIZE);
+
+	for (int i = 0; i < CORPUS_SIZE; ++i) {
+		const int kind = percent();
+
+		if (kind < 25) {
+			corpus.append(pick(replies));
+			continue;
+		}
+
+		QString body;
+		const int length = std::uniform_int_distribution<int>(3, kind < 95 ? 25 : 150)(gen);
+
+		for (int w = 0; w < length; ++w) {
+			const int r = percent();
+
+			if (r < 2)
+				body += pick(links);
+			else if (r < 5)
+				body += pick(emoji);
+			else if (r < 6)
+				body += "<div class=\"a\">&nbsp;</div>";
+			else
+				body += pick(words);
+
+			body += " ";
+		}
+
+		corpus.append(body.trimmed());
+	}
+
+	return corpus;
+}
+
+static const QStringList &
+corpus()
+{
+	static QStringList bodies;
+
+	if (!bodies.isEmpty())
+		return bodies;
+
+	QFile file(qgetenv("NHEKO_BODY_CORPUS"));
+
+	if (!file.fileName().isEmpty() && file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+		QTextStream stream(&file);
+		stream.setCodec("UTF-8");
+
+		while (!stream.atEnd() && bodies.size() < CORPUS_SIZE)
+			bodies.append(stream.readLine());
+	}
+
+	if (bodies.isEmpty())
+		bodies = syntheticCorpus();
+
+	return bodies;
+}
+
+template<QString (*Format)(const QString &)>
+static void
+BM_FormatCorpus(benchmark::State &state)
+{
+	const auto &bodies = corpus();
+
+	for (auto _ : state) {
+		for (const auto &body : bodies)
+			benchmark::DoNotOptimize(Format(body));
+	}
+
+	state.SetItemsProcessed(state.iterations() * bodies.size());
+}
+BENCHMARK_TEMPLATE(BM_FormatCorpus, formatMultiPass)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FormatCorpus, formatSinglePass)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
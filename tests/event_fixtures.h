@@ -0,0 +1,31 @@
+#pragma once
+
+#include <QJsonObject>
+#include <QString>
+
+// Wrap a content into a full event, as it arrives from /sync.
+
+inline QJsonObject
+stateEvent(const QString &type, const QJsonObject &content, const QString &state_key = "")
+{
+	return QJsonObject{
+		{"content", content},
+		{"event_id", "$asdfafdf8af:matrix.org"},
+		{"room_id", "!aasdfaeae23r9:matrix.org"},
+		{"sender", "@alice:matrix.org"},
+		{"origin_server_ts", 1323238293289323LL},
+		{"state_key", state_key},
+		{"type", type}};
+}
+
+inline QJsonObject
+messageEvent(const QJsonObject &content)
+{
+	return QJsonObject{
+		{"content", content},
+		{"event_id", "$asdfafdf8af:matrix.org"},
+		{"room_id", "!aasdfaeae23r9:matrix.org"},
+		{"sender", "@alice:matrix.org"},
+		{"origin_server_ts", 1323238293289323LL},
+		{"type", "m.room.message"}};
+}
@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+
+#include <QString>
+
+#include "EventIdSet.h"
+
+static QString
+eventId(int i)
+{
+	return QString("$%1abcdefgh:matrix.org").arg(i);
+}
+
+TEST(EventIdSet, InsertAndContains)
+{
+	EventIdSet ids;
+
+	EXPECT_FALSE(ids.contains("$a:matrix.org"));
+	EXPECT_TRUE(ids.insert("$a:matrix.org"));
+	EXPECT_TRUE(ids.contains("$a:matrix.org"));
+	EXPECT_FALSE(ids.insert("$a:matrix.org"));
+	EXPECT_FALSE(ids.contains("$b:matrix.org"));
+	EXPECT_EQ(ids.size(), 1);
+
+	ids.clear();
+
+	EXPECT_FALSE(ids.contains("$a:matrix.org"));
+	EXPECT_EQ(ids.size(), 0);
+}
+
+TEST(EventIdSet, KeepsTheLatest)
+{
+	EventIdSet ids(100);
+
+	for (int i = 0; i < 1000; ++i)
+		ids.insert(eventId(i));
+
+	EXPECT_LE(ids.size(), 100);
+
+	// At least the last half of the capacity is remembered.
+	for (int i = 950; i < 1000; ++i)
+		EXPECT_TRUE(ids.contains(eventId(i)));
+
+	EXPECT_FALSE(ids.contains(eventId(0)));
+}
+
+// A room left open for weeks: a million distinct events followed by the
+// duplicates that a sync and a page of history deliver at the edges.
+TEST(EventIdSet, MillionEvents)
+{
+	const int total = 1000000;
+
+	EventIdSet ids;
+
+	for (int i = 0; i < total; ++i) {
+		ASSERT_TRUE(ids.insert(eventId(i))) << i;
+
+		// The events of the previous sync are delivered again.
+		if (i >= 50 && i % 1000 == 0) {
+			for (int j = i - 50; j <= i; ++j)
+				ASSERT_FALSE(ids.insert(eventId(j))) << j;
+		}
+
+		ASSERT_LE(ids.size(), ids.capacity());
+	}
+
+	for (int i = total - ids.capacity() / 2; i < total; ++i)
+		EXPECT_TRUE(ids.contains(eventId(i)));
+
+	// No false positives for events that were never seen.
+	int false_positives = 0;
+
+	for (int i = total; i < 2 * total; ++i) {
+		if (ids.contains(eventId(i)))
+			false_positives += 1;
+	}
+
+	EXPECT_EQ(false_positives, 0);
+}
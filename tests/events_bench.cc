@@ -0,0 +1,254 @@
+#include <benchmark/benchmark.h>
+
+#include <string>
+
+#include <QJsonArray>
+#include <QJsonObject>
+
+#include "MessageEvent.h"
+#include "MessageEventContent.h"
+#include "RoomState.h"
+#include "StateEvent.h"
+
+#include "AliasesEventContent.h"
+#include "AvatarEventContent.h"
+#include "CanonicalAliasEventContent.h"
+#include "CreateEventContent.h"
+#include "HistoryVisibilityEventContent.h"
+#include "JoinRulesEventContent.h"
+#include "MemberEventContent.h"
+#include "NameEventContent.h"
+#include "PowerLevelsEventContent.h"
+#include "TopicEventContent.h"
+
+#include "Audio.h"
+#include "Emote.h"
+#include "File.h"
+#include "Image.h"
+#include "Location.h"
+#include "Notice.h"
+#include "Text.h"
+#include "Video.h"
+
+#include "event_fixtures.h"
+
+using namespace matrix::events;
+
+// Run with --benchmark_format=json (or --benchmark_out=<file>) to get
+// machine-readable results. `make bench` stores them per commit.
+
+static const QJsonObject MEDIA_INFO = QJsonObject{
+	{"h", 110},
+	{"w", 220},
+	{"size", 2120},
+	{"duration", 2140786},
+	{"mimetype", "img/jpeg"},
+	{"thumbnail_url", "https://images.com/image-thumb.jpg"},
+	{"thumbnail_info", QJsonObject{{"h", 11}, {"w", 22}, {"size", 212}, {"mimetype", "img/jpeg"}}}};
+
+//
+// Contents of the state events.
+//
+static const QJsonObject ALIASES = QJsonObject{
+	{"aliases", QJsonArray{"#test:matrix.org", "#test2:matrix.org"}}};
+static const QJsonObject AVATAR = QJsonObject{{"url", "mxc://matrix.org/avatar"}};
+static const QJsonObject CANONICAL_ALIAS = QJsonObject{{"alias", "#test:matrix.org"}};
+static const QJsonObject CREATE = QJsonObject{{"creator", "@alice:matrix.org"}};
+static const QJsonObject HISTORY_VISIBILITY = QJsonObject{{"history_visibility", "shared"}};
+static const QJsonObject JOIN_RULES = QJsonObject{{"join_rule", "public"}};
+static const QJsonObject MEMBER = QJsonObject{
+	{"membership", "join"},
+	{"displayname", "Alice"},
+	{"avatar_url", "mxc://matrix.org/alice"}};
+static const QJsonObject NAME = QJsonObject{{"name", "Room Name"}};
+static const QJsonObject POWER_LEVELS = QJsonObject{
+	{"ban", 50},
+	{"kick", 50},
+	{"events", QJsonObject{{"m.room.name", 100}, {"m.room.power_levels", 100}}},
+	{"users", QJsonObject{{"@alice:matrix.org", 100}, {"@bob:matrix.org", 50}}}};
+static const QJsonObject TOPIC = QJsonObject{{"topic", "Room Topic"}};
+
+//
+// Contents of the message events.
+//
+static const QJsonObject AUDIO = QJsonObject{
+	{"body", "audio"}, {"msgtype", "m.audio"}, {"url", "mxc://localhost/audio"}, {"info", MEDIA_INFO}};
+static const QJsonObject EMOTE = QJsonObject{{"body", "emote"}, {"msgtype", "m.emote"}};
+static const QJsonObject FILE_ = QJsonObject{
+	{"body", "file"}, {"filename", "file.doc"}, {"msgtype", "m.file"}, {"url", "mxc://localhost/file"}, {"info", MEDIA_INFO}};
+static const QJsonObject IMAGE = QJsonObject{
+	{"body", "image"}, {"msgtype", "m.image"}, {"url", "mxc://localhost/image"}, {"info", MEDIA_INFO}};
+static const QJsonObject LOCATION = QJsonObject{
+	{"body", "location"}, {"msgtype", "m.location"}, {"geo_uri", "geo:37.786971,-122.399677"}, {"info", MEDIA_INFO}};
+static const QJsonObject NOTICE = QJsonObject{{"body", "notice"}, {"msgtype", "m.notice"}};
+static const QJsonObject TEXT = QJsonObject{{"body", "text"}, {"msgtype", "m.text"}};
+static const QJsonObject VIDEO = QJsonObject{
+	{"body", "video"}, {"msgtype", "m.video"}, {"url", "mxc://localhost/video"}, {"info", MEDIA_INFO}};
+
+// Decode a full event (or a bare content) from a JSON object.
+template<class T>
+static void
+BM_Deserialize(benchmark::State &state, const QJsonObject &data)
+{
+	for (auto _ : state) {
+		T value;
+		value.deserialize(data);
+		benchmark::DoNotOptimize(value);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+// Encode an already decoded event (or content) back to JSON.
+template<class T>
+static void
+BM_Serialize(benchmark::State &state, const QJsonObject &data)
+{
+	T value;
+	value.deserialize(data);
+
+	for (auto _ : state) {
+		auto json = value.serialize();
+		benchmark::DoNotOptimize(json);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+template<class Content>
+static void
+registerStateContent(const std::string &name, const QString &type, const QJsonObject &content)
+{
+	auto event = stateEvent(type, content);
+
+	benchmark::RegisterBenchmark(
+	  ("BM_Deserialize/" + name).c_str(), BM_Deserialize<Content>, content);
+	benchmark::RegisterBenchmark(
+	  ("BM_Serialize/" + name).c_str(), BM_Serialize<Content>, content);
+	benchmark::RegisterBenchmark(("BM_Deserialize/StateEvent<" + name + ">").c_str(),
+				     BM_Deserialize<StateEvent<Content>>,
+				     event);
+	benchmark::RegisterBenchmark(("BM_Serialize/StateEvent<" + name + ">").c_str(),
+				     BM_Serialize<StateEvent<Content>>,
+				     event);
+}
+
+template<class MsgContent>
+static void
+registerMessageContent(const std::string &name, const QJsonObject &content)
+{
+	benchmark::RegisterBenchmark(
+	  ("BM_Deserialize/messages::" + name).c_str(), BM_Deserialize<MsgContent>, content);
+	benchmark::RegisterBenchmark(
+	  ("BM_Serialize/messages::" + name).c_str(), BM_Serialize<MsgContent>, content);
+	benchmark::RegisterBenchmark(("BM_Deserialize/MessageEvent<messages::" + name + ">").c_str(),
+				     BM_Deserialize<MessageEvent<MsgContent>>,
+				     messageEvent(content));
+	benchmark::RegisterBenchmark(("BM_Serialize/MessageEvent<messages::" + name + ">").c_str(),
+				     BM_Serialize<MessageEvent<MsgContent>>,
+				     messageEvent(content));
+}
+
+static void
+BM_ExtractEventType(benchmark::State &state)
+{
+	const QJsonObject events[] = {
+		stateEvent("m.room.member", MEMBER),
+		stateEvent("m.room.power_levels", POWER_LEVELS),
+		messageEvent(TEXT),
+		stateEvent("m.room.unknown", NAME),
+	};
+
+	for (auto _ : state) {
+		for (const auto &event : events)
+			benchmark::DoNotOptimize(extractEventType(event));
+	}
+
+	state.SetItemsProcessed(state.iterations() * 4);
+}
+BENCHMARK(BM_ExtractEventType);
+
+// A synthetic batch resembling the state of a large room: mostly member
+// events for distinct users, a few room state events and some messages.
+static QJsonArray
+syntheticBatch(int size)
+{
+	QJsonArray events;
+
+	for (int i = 0; i < size; ++i) {
+		if (i % 100 == 0) {
+			events.append(stateEvent("m.room.name", NAME));
+			events.append(stateEvent("m.room.topic", TOPIC));
+			events.append(stateEvent("m.room.power_levels", POWER_LEVELS));
+			i += 2;
+		} else if (i % 10 == 0) {
+			events.append(messageEvent(TEXT));
+		} else {
+			auto user_id = QString("@user%1:matrix.org").arg(i);
+			auto member  = MEMBER;
+			member["displayname"] = QString("User %1").arg(i);
+
+			events.append(stateEvent("m.room.member", member, user_id));
+		}
+	}
+
+	return events;
+}
+
+static void
+BM_RoomStateUpdateFromEvents(benchmark::State &state)
+{
+	const auto events = syntheticBatch(state.range(0));
+
+	for (auto _ : state) {
+		RoomState room_state;
+		room_state.updateFromEvents(events);
+		benchmark::DoNotOptimize(room_state);
+	}
+
+	state.SetItemsProcessed(state.iterations() * events.size());
+}
+BENCHMARK(BM_RoomStateUpdateFromEvents)->Arg(10000)->Unit(benchmark::kMillisecond);
+
+int
+main(int argc, char **argv)
+{
+	// The template benchmarks take their input as an argument, so they are
+	// registered at runtime.
+	registerStateContent<AliasesEventContent>("AliasesEventContent", "m.room.aliases", ALIASES);
+	registerStateContent<AvatarEventContent>("AvatarEventContent", "m.room.avatar", AVATAR);
+	registerStateContent<CanonicalAliasEventContent>(
+	  "CanonicalAliasEventContent", "m.room.canonical_alias", CANONICAL_ALIAS);
+	registerStateContent<CreateEventContent>("CreateEventContent", "m.room.create", CREATE);
+	registerStateContent<HistoryVisibilityEventContent>(
+	  "HistoryVisibilityEventContent", "m.room.history_visibility", HISTORY_VISIBILITY);
+	registerStateContent<JoinRulesEventContent>(
+	  "JoinRulesEventContent", "m.room.join_rules", JOIN_RULES);
+	registerStateContent<MemberEventContent>("MemberEventContent", "m.room.member", MEMBER);
+	registerStateContent<NameEventContent>("NameEventContent", "m.room.name", NAME);
+	registerStateContent<PowerLevelsEventContent>(
+	  "PowerLevelsEventContent", "m.room.power_levels", POWER_LEVELS);
+	registerStateContent<TopicEventContent>("TopicEventContent", "m.room.topic", TOPIC);
+
+	// The common part of every message; the per type benchmarks below add the
+	// fields of each msgtype on top of it.
+	benchmark::RegisterBenchmark(
+	  "BM_Deserialize/MessageEventContent", BM_Deserialize<MessageEventContent>, TEXT);
+	benchmark::RegisterBenchmark("BM_Serialize/RoomEvent<MessageEventContent>",
+				     BM_Serialize<RoomEvent<MessageEventContent>>,
+				     messageEvent(TEXT));
+
+	registerMessageContent<messages::Audio>("Audio", AUDIO);
+	registerMessageContent<messages::Emote>("Emote", EMOTE);
+	registerMessageContent<messages::File>("File", FILE_);
+	registerMessageContent<messages::Image>("Image", IMAGE);
+	registerMessageContent<messages::Location>("Location", LOCATION);
+	registerMessageContent<messages::Notice>("Notice", NOTICE);
+	registerMessageContent<messages::Text>("Text", TEXT);
+	registerMessageContent<messages::Video>("Video", VIDEO);
+
+	benchmark::Initialize(&argc, argv);
+	benchmark::RunSpecifiedBenchmarks();
+
+	return 0;
+}
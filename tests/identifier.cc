@@ -0,0 +1,71 @@
+#include <gtest/gtest.h>
+
+#include <QJsonObject>
+
+#include "Identifier.h"
+#include "MemberEventContent.h"
+#include "StateEvent.h"
+
+using namespace matrix;
+using namespace matrix::events;
+
+TEST(Identifier, Interning)
+{
+	Identifier alice("@alice:matrix.org");
+	Identifier bob("@bob:matrix.org");
+
+	EXPECT_FALSE(alice.isEmpty());
+	EXPECT_NE(alice, bob);
+	EXPECT_EQ(alice, Identifier("@alice:matrix.org"));
+	EXPECT_EQ(alice.handle(), Identifier(QString("@alice:") + "matrix.org").handle());
+	EXPECT_EQ(qHash(alice), qHash(Identifier("@alice:matrix.org")));
+
+	EXPECT_EQ(alice.toString(), "@alice:matrix.org");
+	EXPECT_EQ(bob.toString(), "@bob:matrix.org");
+}
+
+TEST(Identifier, Empty)
+{
+	Identifier empty;
+
+	EXPECT_TRUE(empty.isEmpty());
+	EXPECT_EQ(empty.handle(), 0u);
+	EXPECT_EQ(empty, Identifier(""));
+	EXPECT_TRUE(empty.toString().isEmpty());
+}
+
+TEST(Identifier, Find)
+{
+	int before = Identifier::count();
+
+	EXPECT_TRUE(Identifier::find("@never-seen:matrix.org").isEmpty());
+	EXPECT_EQ(Identifier::count(), before);
+
+	Identifier carol("@carol:matrix.org");
+
+	EXPECT_EQ(Identifier::find("@carol:matrix.org"), carol);
+	EXPECT_EQ(Identifier::count(), before + 1);
+}
+
+TEST(Identifier, SharedByEvents)
+{
+	auto data = QJsonObject{
+		{"content", QJsonObject{{"membership", "join"}}},
+		{"event_id", "$asdfafdf8af:matrix.org"},
+		{"room_id", "!aasdfaeae23r9:matrix.org"},
+		{"sender", "@dave:matrix.org"},
+		{"origin_server_ts", 1323238293289323LL},
+		{"state_key", "@dave:matrix.org"},
+		{"type", "m.room.member"}};
+
+	StateEvent<MemberEventContent> first;
+	first.deserialize(data);
+
+	StateEvent<MemberEventContent> second;
+	second.deserialize(data);
+
+	EXPECT_EQ(first.senderHandle(), first.stateKeyHandle());
+	EXPECT_EQ(first.senderHandle(), second.senderHandle());
+	EXPECT_EQ(first.roomHandle(), second.roomHandle());
+	EXPECT_EQ(first.sender(), "@dave:matrix.org");
+}
@@ -106,6 +106,8 @@ TEST(MessageEvent, File)
 	EXPECT_EQ(file.msgContent().info().mimetype, "application/msword");
 	EXPECT_EQ(file.msgContent().info().size, 24242424);
 	EXPECT_EQ(file.content().body(), "something-important.doc");
+	EXPECT_EQ(file.msgContent().filename(), "something-important.doc");
+	EXPECT_EQ(file.serialize(), event);
 }
 
 TEST(MessageEvent, Image)
@@ -225,6 +227,7 @@ TEST(MessageEvent, Text)
 	text.deserialize(event);
 
 	EXPECT_EQ(text.content().body(), "text message");
+	EXPECT_EQ(text.serialize(), event);
 }
 
 TEST(MessageEvent, Video)
@@ -0,0 +1,122 @@
+#include <benchmark/benchmark.h>
+
+#include <QApplication>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QListView>
+
+#include "MatrixClient.h"
+#include "RoomMessages.h"
+#include "RoomState.h"
+#include "Sync.h"
+#include "TimelineView.h"
+
+// A page of history arrives for a timeline that is on screen. The page goes
+// through the same path as a /messages response: the events are parsed on a
+// worker thread and the rows are inserted into the view as one batch, keeping
+// the scroll position. The time includes the layout of the view.
+//
+// Compare the JSON output of `make bench` between commits.
+//
+// Run with QT_QPA_PLATFORM=offscreen where there is no display.
+
+static const int HISTORY_SIZE = 500;
+
+static const QString ROOM_ID = "!aasdfaeae23r9:matrix.org";
+
+// Text messages from a few senders, oldest first.
+static QJsonArray
+messageEvents(int size, int first_id)
+{
+	QJsonArray events;
+
+	for (int i = 0; i < size; ++i) {
+		events.append(QJsonObject{
+			{"content", QJsonObject{{"body", QString("message %1").arg(first_id + i)}, {"msgtype", "m.text"}}},
+			{"event_id", QString("$%1:matrix.org").arg(first_id + i)},
+			{"room_id", ROOM_ID},
+			{"sender", QString("@user%1:matrix.org").arg(i % 5)},
+			{"origin_server_ts", 1323238293289323LL + first_id + i},
+			{"type", "m.room.message"}});
+	}
+
+	return events;
+}
+
+// The timeline of the initial sync, with the newest HISTORY_SIZE messages.
+static Timeline
+initialTimeline(int page_size)
+{
+	Timeline timeline;
+	timeline.deserialize(QJsonObject{{"events", messageEvents(HISTORY_SIZE, page_size)},
+					 {"limited", false},
+					 {"prev_batch", "t1"}});
+
+	return timeline;
+}
+
+// The page of history before the initial timeline, newest first.
+static RoomMessages
+historyPage(int size)
+{
+	QJsonArray chunk;
+	const auto events = messageEvents(size, 0);
+
+	for (int i = events.size() - 1; i >= 0; --i)
+		chunk.append(events.at(i));
+
+	RoomMessages msgs;
+	msgs.deserialize(QJsonDocument(QJsonObject{{"start", "t1"}, {"end", "t0"}, {"chunk", chunk}}));
+
+	return msgs;
+}
+
+static void
+BM_Backfill(benchmark::State &state)
+{
+	const int page_size = state.range(0);
+	const auto timeline = initialTimeline(page_size);
+	const auto page     = historyPage(page_size);
+
+	// No request leaves the process; the page is handed to the view directly.
+	QSharedPointer<MatrixClient> client(new MatrixClient("localhost"));
+	QSharedPointer<RoomState> room_state(new RoomState);
+
+	for (auto _ : state) {
+		state.PauseTiming();
+		TimelineView view(timeline, client, room_state, ROOM_ID);
+		view.resize(800, 600);
+		view.show();
+
+		// The events of the timeline are parsed on a worker thread too.
+		const auto model = view.findChild<QListView *>()->model();
+		while (model->rowCount() < HISTORY_SIZE)
+			QApplication::processEvents(QEventLoop::WaitForMoreEvents);
+
+		QApplication::processEvents();
+
+		const int rows = model->rowCount();
+		state.ResumeTiming();
+
+		view.addBackwardsEvents(ROOM_ID, page);
+
+		// Wait for the parsed page to be inserted on this thread.
+		while (model->rowCount() < rows + page_size)
+			QApplication::processEvents(QEventLoop::WaitForMoreEvents);
+	}
+
+	state.SetItemsProcessed(state.iterations() * page_size);
+}
+BENCHMARK(BM_Backfill)->Arg(100)->Unit(benchmark::kMillisecond);
+
+int
+main(int argc, char **argv)
+{
+	QApplication app(argc, argv);
+
+	benchmark::Initialize(&argc, argv);
+	benchmark::RunSpecifiedBenchmarks();
+
+	return 0;
+}